@@ -1,6 +1,8 @@
 #include <iostream>
 #include <filesystem>
+#include <cstring>
 #include "src/Application.h"
+#include "src/ProgramBinaryCache.h"
 
 const char* APP_TITLE = "Minecraft Clone - OpenGL Demo - Timothée Dravet";
 const int WINDOW_WIDTH = 1280;
@@ -15,9 +17,18 @@ Model endermanModel (
     "./models/enderman.png" // texture
 );
 
-int main() {
+int main(int argc, char** argv) {
     std::cout << "CWD: " << std::filesystem::current_path() << std::endl;
 
+    // Linked shader programs are cached next to the executable
+    std::filesystem::path exeDir = std::filesystem::absolute(argv[0]).parent_path();
+    ProgramBinaryCache::setDirectory((exeDir / "shader_cache").string());
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--no-shader-cache") == 0) {
+            ProgramBinaryCache::setEnabled(false);
+        }
+    }
+
     try {
         Application app(APP_TITLE, WINDOW_WIDTH, WINDOW_HEIGHT);
         app.run();
@@ -2,6 +2,7 @@
 REM Delete old shader files if they exist
 del *.frag 2>nul
 del *.vert 2>nul
+del *.geom 2>nul
 
 REM Copy new shader files from shaders directory
 copy shaders\*
@@ -11,6 +12,7 @@ cmake --build build --config Release
 IF %ERRORLEVEL% NEQ 0 (
     del *.frag 2>nul
     del *.vert 2>nul
+    del *.geom 2>nul
     echo Build failed.
     exit /b %ERRORLEVEL%
 )
@@ -20,4 +22,5 @@ REM Run the executable if build succeeded
 
 REM Delete shader files after execution
 del *.frag 2>nul
-del *.vert 2>nul
\ No newline at end of file
+del *.vert 2>nul
+del *.geom 2>nul
\ No newline at end of file
@@ -2,8 +2,13 @@
 layout(location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Per-frame camera data, shared with every program (binding FRAME_DATA_BINDING)
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
 
 void main() {
     gl_Position = projection * view * model * vec4(aPos, 1.0);
@@ -1,13 +1,31 @@
 #version 330 core
-in vec4 FragPos; // Reçoit la position du fragment en coordonnées mondiales
+
+#define MAX_BLOCK_TEXTURES 256
+
+// This value should match LayerFlags in BlockRegistry.h
+#define LAYER_NO_SHADOW 2
+
+in vec4 FragPos; // World-space position, written by shadow_point.geom
 uniform vec3 lightPos; // Position de la lumière
 uniform float farPlane; // Portée de la lumière
 
 flat in int TexIndex;
 
+struct BlockMaterialUniform {
+    vec3 ambient;
+    int flags;
+    vec3 specular;
+    float shininess;
+};
+
+// Same table as minecraft.frag (binding BLOCK_MATERIALS_BINDING); only the flags are used here
+layout(std140) uniform BlockMaterials {
+    BlockMaterialUniform blockMaterials[MAX_BLOCK_TEXTURES];
+};
+
 void main() {
-    if (TexIndex == 8 || TexIndex == 4) {
-        discard; // discard Redstone and Torches
+    if (TexIndex >= 0 && TexIndex < MAX_BLOCK_TEXTURES && (blockMaterials[TexIndex].flags & LAYER_NO_SHADOW) != 0) {
+        discard; // Layers flagged LAYER_NO_SHADOW, such as emissive blocks
     }
     // Calculer la distance linéaire de la lumière au fragment
     float lightDistance = length(FragPos.xyz - lightPos);
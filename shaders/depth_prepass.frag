@@ -0,0 +1,28 @@
+#version 330 core
+
+#ifndef CUTOUT
+#define CUTOUT 1 // 0 when no registered layer needs alpha testing
+#endif
+
+flat in int TexIndex;
+in vec2 TexCoord;
+uniform sampler2DArray blockTextures;
+uniform sampler2D modelTexture;
+uniform bool useModelTexture;
+
+// Depth only, but it must drop exactly the fragments minecraft.frag discards
+void main() {
+#if CUTOUT
+    float alpha;
+    if (useModelTexture) {
+        alpha = texture(modelTexture, TexCoord).a;
+    } else if (TexIndex >= 0) {
+        alpha = texture(blockTextures, vec3(TexCoord, float(TexIndex))).a;
+    } else {
+        alpha = 1.0;
+    }
+    if (alpha < 0.1) {
+        discard;
+    }
+#endif
+}
\ No newline at end of file
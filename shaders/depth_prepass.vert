@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec3 aTexCoord;
+
+uniform mat4 model;
+
+// Per-frame camera data, shared with every program (binding FRAME_DATA_BINDING)
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+flat out int TexIndex;
+out vec2 TexCoord;
+
+// Same expression as minecraft.vert: the main pass tests these depths with GL_EQUAL
+invariant gl_Position;
+
+void main() {
+    TexIndex = int(aTexCoord.z);
+    TexCoord = aTexCoord.xy;
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
\ No newline at end of file
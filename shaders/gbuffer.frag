@@ -0,0 +1,45 @@
+#version 330 core
+
+#ifndef CUTOUT
+#define CUTOUT 1 // 0 when no registered layer needs alpha testing
+#endif
+
+// Vertex Shader Inputs (minecraft.vert)
+flat in int TexIndex;
+in vec2 TexCoord;
+in vec3 Normal;
+in vec3 FragPos;
+in float BlockLight;
+in float SkyLight;
+in float AmbientOcclusion;
+
+// G-buffer targets, read back by minecraft.frag built with DEFERRED
+layout(location = 0) out vec4 gAlbedo;   // rgb: albedo, a: ambient occlusion
+layout(location = 1) out vec4 gNormal;   // rgb: normal * 0.5 + 0.5
+layout(location = 2) out vec4 gLighting; // r: block light, g: sky light, b: material layer / 255
+
+uniform sampler2DArray blockTextures;
+uniform sampler2D modelTexture;
+uniform bool useModelTexture;
+
+void main() {
+    // Same texel lookup and alpha test as the forward path in minecraft.frag
+    vec4 texData;
+    if (useModelTexture) {
+        texData = texture(modelTexture, TexCoord);
+    } else if (TexIndex >= 0) {
+        texData = texture(blockTextures, vec3(TexCoord, float(TexIndex)));
+    } else {
+        texData = vec4(1.0f, 0.0f, 1.0f, 1.0f);
+    }
+
+#if CUTOUT
+    if (texData.a < 0.1) {
+        discard;
+    }
+#endif
+
+    gAlbedo = vec4(texData.rgb, AmbientOcclusion);
+    gNormal = vec4(normalize(Normal) * 0.5 + 0.5, 0.0);
+    gLighting = vec4(BlockLight, SkyLight, float(max(TexIndex, 0)) / 255.0, 0.0);
+}
\ No newline at end of file
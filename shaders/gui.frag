@@ -4,12 +4,15 @@ in vec2 TexCoord;
 out vec4 FragColor;
 
 uniform sampler2D guiTexture;
+uniform sampler2DArray guiTextureArray;
+uniform int guiLayer; // >= 0 samples that layer of the block texture array
 uniform vec3 tintColor;
 
 void main() {
-    FragColor = texture(guiTexture, TexCoord) * vec4(tintColor, 1.0);
+    vec4 texColor = guiLayer >= 0 ? texture(guiTextureArray, vec3(TexCoord, float(guiLayer))) : texture(guiTexture, TexCoord);
+    FragColor = texColor * vec4(tintColor, 1.0);
 
     if (FragColor.a < 0.1) {
         discard;
     }
-}
\ No newline at end of file
+}
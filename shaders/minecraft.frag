@@ -1,16 +1,47 @@
 #version 330 core
 
 // These values should match Constants.h
-#define MAX_BLOCK_TEXTURES 16
-#define MAX_POINT_LIGHTS 32
+#define MAX_BLOCK_TEXTURES 256
 #define MAX_SPOT_LIGHTS 8
-
-struct TextureArray {
-        sampler2D diffuseMaps[MAX_BLOCK_TEXTURES];
-};
+#define MAX_POINT_SHADOWS 4
+#define DIR_SHADOW_CASCADES 3
+
+// These values should match LightClusterGrid.h
+#define CLUSTERS_X 16
+#define CLUSTERS_Y 9
+#define CLUSTERS_Z 24
+
+// Variant switches injected by ShaderVariantCache; the defaults build the full shader
+#ifndef POINT_LIGHTS
+#define POINT_LIGHTS 1 // 0 skips the cluster lookup entirely
+#endif
+#ifndef SPOT_LIGHT_BUCKET
+#define SPOT_LIGHT_BUCKET MAX_SPOT_LIGHTS
+#endif
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+#ifndef CUTOUT
+#define CUTOUT 1
+#endif
+#ifndef PCF_RADIUS
+#define PCF_RADIUS 1 // 0 = single tap, 1 = 3x3, 2 = 5x5
+#endif
+#ifndef BAKED_BLOCK_LIGHT
+#define BAKED_BLOCK_LIGHT 1 // 0 when emitters are rendered as point lights instead
+#endif
+#ifndef DEFERRED
+#define DEFERRED 0 // 1 lights a full-screen triangle (deferred.vert) from the G-buffer
+#endif
+
+// Colour of the light flood-filled from torches and other emitters
+const vec3 BLOCK_LIGHT_COLOR = vec3(1.0, 0.8, 0.5);
+// Ambient left in voxels the sky cannot reach (caves, under overhangs)
+const float MIN_SKY_AMBIENT = 0.2;
 
 struct BlockMaterialUniform {
         vec3 ambient;
+        int flags; // LayerFlags, only read by the shadow shaders
         vec3 specular;
         float shininess;
 };
@@ -45,84 +76,238 @@ struct SpotLight {
         float cosOuterCone;
 };
 
-// Global Uniforms (Lights and Camera)
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-uniform SpotLight spotLights[MAX_SPOT_LIGHTS];
+// Per-frame camera data, shared with every program (binding FRAME_DATA_BINDING)
+layout(std140) uniform FrameData {
+        mat4 view;
+        mat4 projection;
+        vec3 viewPos;
+};
 
-// NOUVEAU: Shadow Maps
-uniform sampler2D dirShadowMap;
-uniform samplerCube pointShadowMap;
-uniform float pointFarPlane;
-uniform sampler2D spotShadowMaps[MAX_SPOT_LIGHTS];
-uniform mat4 spotLightSpaceMatrices[MAX_SPOT_LIGHTS];
+// All lights of the frame, uploaded once per frame (binding LIGHTS_BINDING)
+layout(std140) uniform Lights {
+        DirectionalLight dirLight;
+        SpotLight spotLights[MAX_SPOT_LIGHTS];
+        mat4 spotLightSpaceMatrices[MAX_SPOT_LIGHTS];
+        int numPointLights;
+        int numSpotLights;
+        float pointFarPlane;
+        int numPointShadows; // Point lights [0, numPointShadows) may have a shadow
+        vec4 clusterParams; // xy: tile size in pixels, z/w: log-depth slice scale and bias
+        // Shadow atlas tiles, xy: lower corner, zw: size, in texture coordinates. zw is 0 when the
+        // atlas had no room for the light.
+        vec4 pointShadowTiles[MAX_POINT_SHADOWS * 6]; // Six cube faces per shadowed point light
+        vec4 spotShadowTiles[MAX_SPOT_LIGHTS];
+        // Sun cascades, nearest first: each covers view depths up to its cascadeSplits entry
+        mat4 dirLightSpaceMatrices[DIR_SHADOW_CASCADES];
+        vec4 cascadeSplits;
+        vec4 cascadeDepthBias; // Per cascade, in shadow map depth units
+};
+
+#if POINT_LIGHTS
+// Clustered point lights (see LightClusterGrid): 4 texels per light, (offset, count) per cluster, light indices
+uniform samplerBuffer pointLightData;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterLightIndices;
+#endif
 
+#if SHADOWS
+// NOUVEAU: Shadow Maps
+uniform sampler2DArray dirShadowMaps; // One layer per cascade
+uniform sampler2D shadowAtlas; // Point and spot light shadow tiles
+#endif
+
+#if DEFERRED
+// Surface attributes written by gbuffer.frag, unpacked by loadGBuffer() into the globals the
+// forward path reads from its vertex shader inputs
+uniform sampler2D gAlbedo;   // rgb: albedo, a: ambient occlusion
+uniform sampler2D gNormal;   // rgb: normal * 0.5 + 0.5
+uniform sampler2D gLighting; // r: block light, g: sky light, b: material layer / 255
+uniform sampler2D gDepth;
+uniform mat4 clipToWorld;    // inverse(projection * view)
+
+int TexIndex;
+vec3 Normal;
+vec3 FragPos;
+float BlockLight;
+float SkyLight;
+float AmbientOcclusion;
+vec3 Albedo;
+
+void loadGBuffer();
+#else
 // Vertex Shader Inputs
 flat in int TexIndex;
 in vec2 TexCoord;
 in vec3 Normal;
 in vec3 FragPos;
-in vec4 LightSpacePos;
+in float BlockLight;
+in float SkyLight;
+in float AmbientOcclusion;
+#endif
 
 // Fragment Shader Outputs
 out vec4 FragColor;
-// Global Uniforms (World and Light Counts)
-uniform DirectionalLight dirLight;
-uniform int numPointLights;
-uniform int numSpotLights;
-uniform TextureArray blockTextures;
-uniform BlockMaterialUniform blockMaterials[MAX_BLOCK_TEXTURES];
-uniform vec3 viewPos;
+// Global Uniforms (World)
+uniform sampler2DArray blockTextures; // One layer per block texture, TexIndex is the layer
+uniform sampler2D modelTexture;
+uniform bool useModelTexture;
+// Indexed by texture layer, filled from the BlockRegistry (binding BLOCK_MATERIALS_BINDING)
+layout(std140) uniform BlockMaterials {
+        BlockMaterialUniform blockMaterials[MAX_BLOCK_TEXTURES];
+};
 
 
 // Function Prototypes
-vec3 calcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 texColor, BlockMaterialUniform material);
-vec3 calcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor, samplerCube shadowMap, float farPlane, BlockMaterialUniform material);
-vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor, sampler2D shadowMap, mat4 lightSpaceMatrix, BlockMaterialUniform material);
-float DirShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir);
-float PointShadowCalculation(vec3 fragPos, vec3 lightPos, samplerCube shadowMap, float farPlane);
-float SpotShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir, sampler2D shadowMap);
+// Shadow factors are computed by the caller so shadowless variants never touch a sampler
+vec3 calcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 texColor, float shadow, BlockMaterialUniform material);
+vec3 calcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor, float shadow, BlockMaterialUniform material);
+vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor, float shadow, BlockMaterialUniform material);
+#if SHADOWS
+float DirShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir);
+float PointShadowCalculation(vec3 fragPos, vec3 lightPos, int shadowIndex, float farPlane);
+float SpotShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir, vec4 tile);
+#endif
+#if POINT_LIGHTS
+PointLight fetchPointLight(int index);
+int clusterIndex(vec3 fragPos);
+#endif
 
 
 void main() {
+#if DEFERRED
+        loadGBuffer();
+#endif
         vec3 norm = normalize(Normal);
         vec3 viewDir = normalize(viewPos - FragPos);
-        vec2 uv = TexCoord;
 
-        BlockMaterialUniform currentMaterial = blockMaterials[TexIndex];
+        BlockMaterialUniform currentMaterial = blockMaterials[max(TexIndex, 0)];
 
+#if DEFERRED
+        // Cutout texels were discarded when the G-buffer was written
+        vec4 texData = vec4(Albedo, 1.0);
+#else
+        vec2 uv = TexCoord;
         vec4 texData;
-        if (TexIndex >= 0 && TexIndex < MAX_BLOCK_TEXTURES) {
-                texData = texture(blockTextures.diffuseMaps[TexIndex], uv);
+        if (useModelTexture) {
+                texData = texture(modelTexture, uv);
+        } else if (TexIndex >= 0) {
+                texData = texture(blockTextures, vec3(uv, float(TexIndex)));
         } else {
                 texData = vec4(1.0f, 0.0f, 1.0f, 1.0f);
         }
 
+#if CUTOUT
         if (texData.a < 0.1) {
             discard;
         }
+#endif
+#endif
 
         vec3 texColor = texData.rgb;
         // Start with only ambient from DirLight for global lighting
-        vec3 result = dirLight.ambient * currentMaterial.ambient * texColor;
-        result += calcDirectionalLight(dirLight, norm, viewDir, texColor, currentMaterial);
-
-        for (int i = 0; i < numPointLights && i < MAX_POINT_LIGHTS; i++) {
-                result += calcPointLight(pointLights[i], norm, FragPos, viewDir, texColor, pointShadowMap, pointFarPlane, currentMaterial);
+        // Baked AO only darkens the indirect terms, direct light keeps its own shadows
+        vec3 result = dirLight.ambient * currentMaterial.ambient * texColor * mix(MIN_SKY_AMBIENT, 1.0, SkyLight) * AmbientOcclusion;
+#if SHADOWS
+        float dirShadow = DirShadowCalculation(FragPos, norm, normalize(-dirLight.direction));
+#else
+        // Cheap mode: the baked sky light stands in for the sun's shadow map
+        float dirShadow = SkyLight;
+#endif
+        result += calcDirectionalLight(dirLight, norm, viewDir, texColor, dirShadow, currentMaterial);
+
+#if BAKED_BLOCK_LIGHT
+        // Every emitter at once, already attenuated per voxel during meshing
+        result += BLOCK_LIGHT_COLOR * BlockLight * currentMaterial.ambient * texColor * AmbientOcclusion;
+#endif
+
+#if POINT_LIGHTS
+        // Only the lights whose range overlaps this fragment's cluster
+        uvec2 clusterRange = texelFetch(clusterGrid, clusterIndex(FragPos)).xy;
+        for (uint i = 0u; i < clusterRange.y; i++) {
+                int lightIndex = int(texelFetch(clusterLightIndices, int(clusterRange.x + i)).r);
+                PointLight light = fetchPointLight(lightIndex);
+#if SHADOWS
+                float shadow = lightIndex < numPointShadows ? PointShadowCalculation(FragPos, light.position, lightIndex, pointFarPlane) : 1.0;
+#else
+                float shadow = 1.0;
+#endif
+                result += calcPointLight(light, norm, FragPos, viewDir, texColor, shadow, currentMaterial);
         }
-
-        for (int i = 0; i < numSpotLights && i < MAX_SPOT_LIGHTS; i++) {
-                result += calcSpotLight(spotLights[i], norm, FragPos, viewDir, texColor, spotShadowMaps[i], spotLightSpaceMatrices[i], currentMaterial);
+#endif
+
+        // Constant loop bound: the compiler can unroll, and an empty bucket drops the loop entirely
+#if SPOT_LIGHT_BUCKET > 0
+        for (int i = 0; i < SPOT_LIGHT_BUCKET; i++) {
+                if (i >= numSpotLights) break;
+#if SHADOWS
+                vec4 fragPosSpotSpace = spotLightSpaceMatrices[i] * vec4(FragPos, 1.0f);
+                float shadow = SpotShadowCalculation(fragPosSpotSpace, norm, normalize(spotLights[i].position - FragPos), spotShadowTiles[i]);
+#else
+                float shadow = 1.0;
+#endif
+                result += calcSpotLight(spotLights[i], norm, FragPos, viewDir, texColor, shadow, currentMaterial);
         }
+#endif
 
         FragColor = vec4(result, 1.0);
 }
 
-vec3 calcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 texColor, BlockMaterialUniform material) {
+#if DEFERRED
+void loadGBuffer() {
+        ivec2 pixel = ivec2(gl_FragCoord.xy);
+        float depth = texelFetch(gDepth, pixel, 0).r;
+        if (depth == 1.0) {
+                discard; // Nothing drawn here, the clear colour shows through
+        }
+
+        vec4 albedo = texelFetch(gAlbedo, pixel, 0);
+        vec4 lighting = texelFetch(gLighting, pixel, 0);
+        Albedo = albedo.rgb;
+        AmbientOcclusion = albedo.a;
+        Normal = texelFetch(gNormal, pixel, 0).rgb * 2.0 - 1.0;
+        BlockLight = lighting.r;
+        SkyLight = lighting.g;
+        TexIndex = int(lighting.b * 255.0 + 0.5);
+
+        vec4 clip = vec4(vec2(pixel) + 0.5, depth, 1.0);
+        clip.xy = clip.xy / vec2(textureSize(gDepth, 0)) * 2.0 - 1.0;
+        clip.z = clip.z * 2.0 - 1.0;
+        vec4 world = clipToWorld * clip;
+        FragPos = world.xyz / world.w;
+}
+#endif
+
+#if POINT_LIGHTS
+PointLight fetchPointLight(int index) {
+        vec4 positionRange = texelFetch(pointLightData, index * 4 + 0);
+        vec4 diffuseConstant = texelFetch(pointLightData, index * 4 + 1);
+        vec4 specularLinear = texelFetch(pointLightData, index * 4 + 2);
+        vec4 ambientExponant = texelFetch(pointLightData, index * 4 + 3);
+
+        PointLight light;
+        light.position = positionRange.xyz;
+        light.ambient = ambientExponant.rgb;
+        light.diffuse = diffuseConstant.rgb;
+        light.specular = specularLinear.rgb;
+        light.constant = diffuseConstant.w;
+        light.linear = specularLinear.w;
+        light.exponant = ambientExponant.w;
+        return light;
+}
+
+int clusterIndex(vec3 fragPos) {
+        float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+        ivec2 tile = ivec2(gl_FragCoord.xy / clusterParams.xy);
+        int slice = int(floor(log(max(viewDepth, 1e-4)) * clusterParams.z - clusterParams.w));
+        ivec3 cluster = clamp(ivec3(tile, slice), ivec3(0), ivec3(CLUSTERS_X - 1, CLUSTERS_Y - 1, CLUSTERS_Z - 1));
+        return cluster.x + CLUSTERS_X * (cluster.y + CLUSTERS_Y * cluster.z);
+}
+#endif
+
+vec3 calcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 texColor, float shadow, BlockMaterialUniform material) {
         vec3 lightDir = normalize(-light.direction);
         vec3 ambient = vec3(0.0);
 
-        float shadow = DirShadowCalculation(LightSpacePos, normal, lightDir);
-
         // Diffuse
         float diff = max(dot(normal, lightDir), 0.0);
         vec3 diffuse = light.diffuse * diff * texColor * shadow;
@@ -137,12 +322,10 @@ vec3 calcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec
         return ambient + diffuse + specular;
 }
 
-vec3 calcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor, samplerCube shadowMap, float farPlane, BlockMaterialUniform material) {
+vec3 calcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor, float shadow, BlockMaterialUniform material) {
         vec3 lightDir = normalize(light.position - fragPos);
         float distance = length(light.position - fragPos);
 
-        float shadow = PointShadowCalculation(fragPos, light.position, shadowMap, farPlane);
-
         vec3 ambient = vec3(0.0);
 
         // Diffuse
@@ -162,7 +345,7 @@ vec3 calcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, v
         return ambient + diffuse + specular;
 }
 
-vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor, sampler2D shadowMap, mat4 lightSpaceMatrix, BlockMaterialUniform material) {
+vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 texColor, float shadow, BlockMaterialUniform material) {
         vec3 lightDir = normalize(light.position - fragPos);
         vec3 spotDir = normalize(normalize(light.direction));
         float distance = length(light.position - fragPos);
@@ -170,8 +353,6 @@ vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec
         float cosDir = dot(-lightDir, spotDir);
         float spotIntensity = smoothstep(light.cosOuterCone, light.cosInnerCone, cosDir);
 
-        vec4 fragPosLightSpace = lightSpaceMatrix * vec4(fragPos, 1.0f);
-        float shadow = SpotShadowCalculation(fragPosLightSpace, normal, lightDir, shadowMap);
         vec3 ambient = vec3(0.0);
 
         // Diffuse
@@ -191,7 +372,16 @@ vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec
         return ambient + diffuse + specular;
 }
 
-float DirShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir) {
+#if SHADOWS
+float DirShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir) {
+    // 0. Cascade covering this view depth; past the last one, no shadow
+    float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+    int cascade = 0;
+    while (cascade < DIR_SHADOW_CASCADES && viewDepth > cascadeSplits[cascade]) cascade++;
+    if (cascade == DIR_SHADOW_CASCADES)
+        return 1.0;
+    vec4 fragPosLightSpace = dirLightSpaceMatrices[cascade] * vec4(fragPos, 1.0);
+
     // 1. Division de perspective
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     // 2. Transformation vers l'espace [0, 1]
@@ -200,18 +390,26 @@ float DirShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir) {
     if(projCoords.z > 1.0)
         return 1.0;
     // 4. Lecture de la profondeur la plus proche (Depth Map)
-    float closestDepth = texture(dirShadowMap, projCoords.xy).r;
+    float closestDepth = texture(dirShadowMaps, vec3(projCoords.xy, float(cascade))).r;
     // 5. Profondeur du fragment actuel
     float currentDepth = projCoords.z;
-    // 6. Bias pour éviter le Shadow Acne
-    float bias = max(0.0008 * (1.0 - dot(normal, lightDir)), 0.008);
+    // 6. Bias pour éviter le Shadow Acne: a few cascade texels, more at grazing angles to the sun
+    float bias = cascadeDepthBias[cascade] * (1.0 + 2.0 * (1.0 - dot(normal, lightDir)));
     // 7. Comparaison de la profondeur
     float shadow = currentDepth - bias > closestDepth ? 0.0 : 1.0;
 
     return shadow;
 }
 
-float SpotShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir, sampler2D shadowMap) {
+// Atlas texels outside the tile belong to other lights: keep every tap half a texel inside
+vec2 atlasCoords(vec4 tile, vec2 tileCoords) {
+    vec2 halfTexel = 0.5 / vec2(textureSize(shadowAtlas, 0));
+    return clamp(tile.xy + tileCoords * tile.zw, tile.xy + halfTexel, tile.xy + tile.zw - halfTexel);
+}
+
+float SpotShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir, vec4 tile) {
+    if (tile.z == 0.0)
+        return 1.0;
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5;
 
@@ -221,27 +419,47 @@ float SpotShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir,
     if(projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0)
         return 1.0;
 
-    // PCF pour lissage
+    // PCF pour lissage, (2 * PCF_RADIUS + 1)^2 taps
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
-    for(int x = -1; x <= 1; ++x) {
-        for(int y = -1; y <= 1; ++y) {
-            float closestDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
+    vec2 texelSize = 1.0 / (tile.zw * vec2(textureSize(shadowAtlas, 0)));
+    for(int x = -PCF_RADIUS; x <= PCF_RADIUS; ++x) {
+        for(int y = -PCF_RADIUS; y <= PCF_RADIUS; ++y) {
+            float closestDepth = texture(shadowAtlas, atlasCoords(tile, projCoords.xy + vec2(x, y) * texelSize)).r;
             float currentDepth = projCoords.z;
             float bias = max(0.0005 * (1.0 - dot(normal, lightDir)), 0.002);
             shadow += currentDepth - bias > closestDepth ? 0.0 : 1.0;
         }
     }
-    return shadow / 9.0;
+    return shadow / float((2 * PCF_RADIUS + 1) * (2 * PCF_RADIUS + 1));
 }
 
-float PointShadowCalculation(vec3 fragPos, vec3 lightPos, samplerCube shadowMap, float farPlane) {
+// Basis of each cube face's view, matching CUBE_FACE_DIRECTIONS and CUBE_FACE_UPS in Renderer.cpp
+const vec3 CUBE_FACE_FORWARD[6] = vec3[](vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1));
+const vec3 CUBE_FACE_RIGHT[6] = vec3[](vec3(0, 0, -1), vec3(0, 0, 1), vec3(1, 0, 0), vec3(1, 0, 0), vec3(1, 0, 0), vec3(-1, 0, 0));
+const vec3 CUBE_FACE_UP[6] = vec3[](vec3(0, -1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1), vec3(0, -1, 0), vec3(0, -1, 0));
+
+// Stored light distance in the direction dir, read from the cube face tile that dir points into
+float sampleCubeTile(int shadowIndex, vec3 dir) {
+    vec3 absDir = abs(dir);
+    int face;
+    if (absDir.x >= absDir.y && absDir.x >= absDir.z) face = dir.x > 0.0 ? 0 : 1;
+    else if (absDir.y >= absDir.z) face = dir.y > 0.0 ? 2 : 3;
+    else face = dir.z > 0.0 ? 4 : 5;
+
+    // 90 degree projection: the face's view coordinates over its depth
+    vec2 ndc = vec2(dot(CUBE_FACE_RIGHT[face], dir), dot(CUBE_FACE_UP[face], dir)) / dot(CUBE_FACE_FORWARD[face], dir);
+    return texture(shadowAtlas, atlasCoords(pointShadowTiles[shadowIndex * 6 + face], ndc * 0.5 + 0.5)).r;
+}
+
+float PointShadowCalculation(vec3 fragPos, vec3 lightPos, int shadowIndex, float farPlane) {
+    if (pointShadowTiles[shadowIndex * 6].z == 0.0)
+        return 1.0;
     vec3 fragToLight = fragPos - lightPos;
     float currentDistance = length(fragToLight);
 
     // PCF
     float shadow = 0.0;
-    int pcfSamples = 4;
+    const int pcfSamples = PCF_RADIUS == 0 ? 1 : min(4 * PCF_RADIUS, 20);
     float spread = 0.005;
     float bias = 0.05;
     vec3 sampleOffsetDirections[20] = vec3[](vec3( 1,  1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1, 1,  1), 
@@ -252,9 +470,10 @@ float PointShadowCalculation(vec3 fragPos, vec3 lightPos, samplerCube shadowMap,
     );
 
     for (int i = 0; i < pcfSamples; ++i) {
-        float closestDepth = texture(shadowMap, fragToLight + sampleOffsetDirections[i] * spread).r;
+        float closestDepth = sampleCubeTile(shadowIndex, fragToLight + sampleOffsetDirections[i] * spread);
         closestDepth *= farPlane; // De-normalize
         shadow += currentDistance - bias > closestDepth ? 0.0 : 1.0;
     }
     return shadow / float(pcfSamples);
-}
\ No newline at end of file
+}
+#endif
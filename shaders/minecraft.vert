@@ -2,16 +2,29 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec3 aTexCoord;
+layout(location = 3) in uint aLight; // Packed by Chunk::packVertexLight, bits 0-3 block light, 4-7 sky light, 8-9 AO
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat4 lightSpaceMatrix; // AJOUTÉ
+
+// Per-frame camera data, shared with every program (binding FRAME_DATA_BINDING)
+layout(std140) uniform FrameData {
+        mat4 view;
+        mat4 projection;
+        vec3 viewPos;
+};
 
 flat out int TexIndex;
 out vec2 TexCoord;
 out vec3 Normal;
 out vec3 FragPos;
-out vec4 LightSpacePos; // AJOUTÉ
+out float BlockLight;    // Brightness of the baked block light, 0..1
+out float SkyLight;      // Brightness of the baked sky light, 0..1
+out float AmbientOcclusion;
+
+// Must match depth_prepass.vert bit for bit, the depth pre-pass is tested with GL_EQUAL
+invariant gl_Position;
+
+// Corner AO level 0 (two occluding sides) to 3 (open)
+const float AO_CURVE[4] = float[4](0.45, 0.65, 0.85, 1.0);
 
 void main() {
         TexCoord = aTexCoord.xy;
@@ -19,5 +32,11 @@ void main() {
         FragPos = vec3(model * vec4(aPos, 1.0f));
         Normal = mat3(transpose(inverse(model))) * aNormal;
         gl_Position = projection * view * model * vec4(aPos, 1.0);
-        LightSpacePos = lightSpaceMatrix * model * vec4(aPos, 1.0f); // AJOUTÉ
+
+        // Each level below 15 dims the light by 20%, level 0 is dark
+        uint blockLevel = aLight & 15u;
+        uint skyLevel = (aLight >> 4) & 15u;
+        BlockLight = blockLevel > 0u ? pow(0.8, float(15u - blockLevel)) : 0.0;
+        SkyLight = skyLevel > 0u ? pow(0.8, float(15u - skyLevel)) : 0.0;
+        AmbientOcclusion = AO_CURVE[(aLight >> 8) & 3u];
 }
\ No newline at end of file
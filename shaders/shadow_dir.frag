@@ -1,20 +1,47 @@
 #version 330 core
 
-#define MAX_BLOCK_TEXTURES 16
+#define MAX_BLOCK_TEXTURES 256
+
+// These values should match LayerFlags in BlockRegistry.h
+#define LAYER_CUTOUT 1
+#define LAYER_NO_SHADOW 2
+
+#ifndef CUTOUT
+#define CUTOUT 1 // 0 when no registered layer needs alpha testing
+#endif
 
 flat in int TexIndex;
 in vec2 TexCoord;
-uniform sampler2D diffuseMaps[MAX_BLOCK_TEXTURES];
+uniform sampler2DArray blockTextures;
+
+struct BlockMaterialUniform {
+    vec3 ambient;
+    int flags;
+    vec3 specular;
+    float shininess;
+};
+
+// Same table as minecraft.frag (binding BLOCK_MATERIALS_BINDING); only the flags are used here
+layout(std140) uniform BlockMaterials {
+    BlockMaterialUniform blockMaterials[MAX_BLOCK_TEXTURES];
+};
 
 void main() {
-    if (TexIndex == 8 || TexIndex == 4) {
-        discard; // discard redstone and torches
+    if (TexIndex < 0 || TexIndex >= MAX_BLOCK_TEXTURES) {
+        return;
+    }
+
+    int flags = blockMaterials[TexIndex].flags;
+    if ((flags & LAYER_NO_SHADOW) != 0) {
+        discard; // emissive blocks such as redstone and torches
     }
 
-    if (TexIndex == 7 || TexIndex == 9) { // Leaves and Glass
-        vec4 texColor = texture(diffuseMaps[TexIndex], TexCoord);
+#if CUTOUT
+    if ((flags & LAYER_CUTOUT) != 0) { // Leaves and Glass
+        vec4 texColor = texture(blockTextures, vec3(TexCoord, float(TexIndex)));
         if (texColor.a < 0.1) {
             discard;
         }
     }
-}
\ No newline at end of file
+#endif
+}
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec3 aTexCoord;
+
+uniform mat4 model;
+
+flat out int vTexIndex;
+
+// World space only: the geometry shader projects each triangle once per cube face
+void main() {
+    vTexIndex = int(aTexCoord.z);
+    gl_Position = model * vec4(aPos, 1.0);
+}
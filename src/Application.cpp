@@ -1,13 +1,17 @@
 #include "Application.h"
+#include "GLState.h"
 #include <iostream>
 #include <sstream>
 #include <filesystem>
+#include <chrono>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Light.h"
 #include "Constants.h"
 #include "Chunk.h"
 #include "Block.h"
 #include "World.h"
+#include "BlockRegistry.h"
+#include "ProgramBinaryCache.h"
 
 namespace {
     const double ZOOM_SENSITIVITY = -3.0;
@@ -135,6 +139,7 @@ Application::~Application() {
 }
 
 void Application::run() {
+    m_startTime = std::chrono::steady_clock::now();
     init();
     mainLoop();
 }
@@ -172,14 +177,22 @@ void Application::init() {
         throw std::runtime_error("GLEW initialization failed");
     }
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::enable(GL_CULL_FACE);
+    GLState::cullFace(GL_BACK);
     glClearColor(0.53f, 0.81f, 0.98f, 1.0f);
 
+    BlockRegistry::init();
+
     m_renderer = std::make_unique<Renderer>();
     m_renderer->init();
 
+    // Cached shadow maps are re-rendered only when something inside their light's range changes
+    m_world.addChangeListener([this](const glm::vec3& boxMin, const glm::vec3& boxMax) {
+        m_renderer->invalidateShadows(boxMin, boxMax);
+    });
+    m_scene.addModelChangeListener([this](size_t modelIndex) { m_renderer->onModelChanged(modelIndex); });
+
     m_debugDrawer = std::make_unique<DebugDrawer>();
     m_debugDrawer->init();
 
@@ -189,19 +202,14 @@ void Application::init() {
 void Application::initResources() {
     m_world.generate(2, -1);
 
-    const auto& pathToIndex = Chunk::m_pathToTextureIndex;
-    int numTexturesToBind = (int)pathToIndex.size();
-    if (numTexturesToBind > MAX_BLOCK_TEXTURES) {
+    const auto& layerPaths = BlockRegistry::getLayerPaths();
+    if ((int)layerPaths.size() > MAX_BLOCK_TEXTURES) {
         throw std::runtime_error("Too many block textures!");
     }
 
-    m_blockTextures = std::make_unique<Texture2D[]>(MAX_BLOCK_TEXTURES);
-    for (const auto& pair : pathToIndex) {
-        const std::string& path = pair.first;
-        int index = pair.second;
-        if (!m_blockTextures[index].loadTexture(path, true)) {
-            std::cerr << "Failed to load texture: " << path << std::endl;
-        }
+    m_blockTextures = std::make_unique<TextureArray>();
+    if (!m_blockTextures->loadLayers(layerPaths, BLOCK_TEXTURE_SIZE, true)) {
+        std::cerr << "Failed to load some block textures" << std::endl;
     }
 
     m_selectableBlocks = {
@@ -238,6 +246,7 @@ void Application::mainLoop() {
         double currentTime = glfwGetTime();
         double deltaTime = currentTime - m_lastTime;
 
+        GLState::beginFrame();
         glfwPollEvents();
         processInput(deltaTime);
         update(deltaTime);
@@ -245,6 +254,17 @@ void Application::mainLoop() {
 
         glfwSwapBuffers(m_window);
         m_lastTime = currentTime;
+
+        if (!m_firstFrameReported) {
+            // Compare runs with and without --no-shader-cache to see what the binary cache saves
+            glFinish();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+            std::cout << "Time to first frame: " << ms << " ms (program binaries: "
+                      << (ProgramBinaryCache::isAvailable() ? "on" : "off") << ", "
+                      << ProgramBinaryCache::getHits() << " cached, "
+                      << ProgramBinaryCache::getMisses() << " compiled)" << std::endl;
+            m_firstFrameReported = true;
+        }
     }
 }
 
@@ -356,7 +376,7 @@ void Application::updateEnderman(double deltaTime) {
 
             if (block != BlockType::AIR && blockAbove == BlockType::AIR && blockTwoAbove == BlockType::AIR && block != BlockType::LEAVES) {
                 // Update the model within the scene, not the global one
-                m_scene.models[0].position = chunkPos + glm::vec3(localX + 0.5f, y + 0.5f, localZ + 0.5f);
+                m_scene.setModelPosition(0, chunkPos + glm::vec3(localX + 0.5f, y + 0.5f, localZ + 0.5f));
                 return; // Found a spot
             }
         }
@@ -368,11 +388,10 @@ void Application::render() {
 
     if (m_debug) {
         RaycastHit hit = raycastWorld(m_world, m_scene, m_meshCache, m_camera.getPosition(), glm::normalize(m_camera.getLook()), 16.0f);
-        m_debugDrawer->drawRaycast(m_camera, hit, m_width, m_height);
+        m_debugDrawer->drawRaycast(m_camera, hit);
     }
 
-    const auto& pathToIndex = Chunk::m_pathToTextureIndex;
-    int numTextures = (int)pathToIndex.size();
+    int numTextures = BlockRegistry::getLayerCount();
 
     m_renderer->drawInventoryHUD(m_blockTextures.get(), numTextures, m_selectedBlockIndex,
                                  m_selectableBlocks, m_width, m_height);
@@ -402,6 +421,7 @@ void Application::onKey(GLFWwindow* window, int key, int scancode, int action, i
             glPolygonMode(GL_FRONT_AND_BACK, app->m_wireframe ? GL_LINE : GL_FILL);
             break;
         case GLFW_KEY_F2: app->m_debug = !app->m_debug; break;
+        case GLFW_KEY_F3: app->runEditBenchmark(); break;
         case GLFW_KEY_1: setBlock(BlockType::GRASS); break;
         case GLFW_KEY_2: setBlock(BlockType::REDSTONE); break;
         case GLFW_KEY_3: setBlock(BlockType::DIRT); break;
@@ -428,6 +448,30 @@ void Application::onKey(GLFWwindow* window, int key, int scancode, int action, i
         case GLFW_KEY_P:
             app->m_isPaused = !app->m_isPaused;
             break;
+        case GLFW_KEY_O:
+            app->m_renderer->setShadowsEnabled(!app->m_renderer->getShadowsEnabled());
+            std::cout << "Sun shadows: " << (app->m_renderer->getShadowsEnabled() ? "shadow maps" : "sky light only") << std::endl;
+            break;
+        case GLFW_KEY_L:
+            app->m_renderer->setDynamicBlockLights(!app->m_renderer->getDynamicBlockLights());
+            std::cout << "Block lights: " << (app->m_renderer->getDynamicBlockLights() ? "dynamic point lights" : "baked") << std::endl;
+            break;
+        case GLFW_KEY_Z:
+            app->m_renderer->setDepthPrepassEnabled(!app->m_renderer->getDepthPrepassEnabled());
+            std::cout << "Depth pre-pass: " << (app->m_renderer->getDepthPrepassEnabled() ? "on" : "off") << std::endl;
+            break;
+        case GLFW_KEY_G:
+            app->m_renderer->setDeferredShading(!app->m_renderer->getDeferredShading());
+            std::cout << "Shading: " << (app->m_renderer->getDeferredShading() ? "deferred" : "forward") << std::endl;
+            break;
+        case GLFW_KEY_C:
+            app->m_renderer->setSectionCulling(!app->m_renderer->getSectionCulling());
+            std::cout << "Section visibility culling: " << (app->m_renderer->getSectionCulling() ? "on" : "off") << std::endl;
+            break;
+        case GLFW_KEY_V:
+            app->m_renderer->setOcclusionCulling(!app->m_renderer->getOcclusionCulling());
+            std::cout << "Software occlusion culling: " << (app->m_renderer->getOcclusionCulling() ? "on" : "off") << std::endl;
+            break;
     }
 }
 
@@ -463,7 +507,59 @@ void Application::onFramebufferSize(GLFWwindow* window, int width, int height) {
     Application* app = static_cast<Application*>(glfwGetWindowUserPointer(window));
     app->m_width = width;
     app->m_height = height;
-    glViewport(0, 0, width, height);
+    GLState::viewport(0, 0, width, height);
+}
+
+void Application::runEditBenchmark() {
+    const int EDIT_COUNT = 200;
+    using Clock = std::chrono::high_resolution_clock;
+
+    // Benchmark on the first solid block under the player so the edited section holds real geometry
+    glm::vec3 pos = glm::floor(m_camera.getPosition() + glm::vec3(0.5f));
+    Chunk* chunk = m_world.getChunkAt(pos);
+    if (!chunk) {
+        std::cout << "Edit benchmark: no chunk under the player" << std::endl;
+        return;
+    }
+    while (pos.y > 0.0f && m_world.getBlockAt(pos) == BlockType::AIR) {
+        pos.y -= 1.0f;
+    }
+    BlockType original = m_world.getBlockAt(pos);
+
+    // glFinish() so the timings include the upload, i.e. the edit-to-visible latency
+    auto start = Clock::now();
+    for (int i = 0; i < EDIT_COUNT; i++) {
+        chunk->buildMesh();
+        glFinish();
+    }
+    double fullRebuildMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / EDIT_COUNT;
+
+    // Same remesh without baked AO, to isolate the cost of the corner lookups
+    bool aoEnabled = Chunk::getAmbientOcclusionEnabled();
+    Chunk::setAmbientOcclusionEnabled(false);
+    start = Clock::now();
+    for (int i = 0; i < EDIT_COUNT; i++) {
+        chunk->buildMesh();
+        glFinish();
+    }
+    double noAORebuildMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / EDIT_COUNT;
+    Chunk::setAmbientOcclusionEnabled(aoEnabled);
+    chunk->buildMesh();
+
+    start = Clock::now();
+    for (int i = 0; i < EDIT_COUNT; i++) {
+        m_world.setBlockAt(pos, (i % 2 == 0) ? BlockType::AIR : BlockType::STONE);
+        glFinish();
+    }
+    double sectionEditMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / EDIT_COUNT;
+
+    m_world.setBlockAt(pos, original);
+
+    std::cout << "Edit benchmark (" << EDIT_COUNT << " edits at " << pos.x << ", " << pos.y << ", " << pos.z << "):" << std::endl;
+    std::cout << "  full chunk remesh: " << fullRebuildMs << " ms/edit" << std::endl;
+    std::cout << "  without AO:        " << noAORebuildMs << " ms/edit (AO adds "
+              << (fullRebuildMs - noAORebuildMs) << " ms)" << std::endl;
+    std::cout << "  section remesh:    " << sectionEditMs << " ms/edit" << std::endl;
 }
 
 void Application::showFPS() {
@@ -481,7 +577,27 @@ void Application::showFPS() {
         outs.precision(3);
         outs << std::fixed << m_title << "    "
              << "FPS: " << fps << "    "
-             << "Frame Time: " << msPerFrame << " (ms)";
+             << "Frame Time: " << msPerFrame << " (ms)    "
+             << "GL state calls: " << GLState::getLastFrameStats().issued << " issued, "
+             << GLState::getLastFrameStats().skipped << " skipped    "
+             << "Shadow map updates: " << m_renderer->getShadowMapUpdates() << "    "
+             << (m_renderer->getDeferredShading() ? "Deferred, " : (m_renderer->getDepthPrepassEnabled() ? "Forward with pre-pass, " : "Forward, "))
+             << m_renderer->getMainPassFragments()
+             << (m_renderer->countsShaderInvocations() ? " fragments shaded" : " samples passed");
+        if (m_renderer->getSectionCulling()) {
+            outs << "    Sections: " << m_renderer->getVisibleSectionCount() << "/" << m_renderer->getSectionCount() << " reachable";
+        }
+        if (m_renderer->getOcclusionCulling()) {
+            const OcclusionCuller& occlusion = m_renderer->getOcclusionCuller();
+            outs << "    Occluded: " << occlusion.getOccludedCount() << "/" << occlusion.getTestedCount() << " sections ("
+                 << occlusion.getOccluderCount() << " occluders)";
+        }
+        if (m_renderer->getDynamicBlockLights()) {
+            const LightIndex::QueryStats& lights = m_renderer->getLightSelectionStats();
+            outs << "    Emitters: " << lights.selected << "/" << lights.indexed << " selected ("
+                 << lights.candidates << " scored in " << lights.bucketsVisited << " chunks), "
+                 << m_renderer->getAggregatedLightCount() << " lights after merging";
+        }
 
         glfwSetWindowTitle(m_window, outs.str().c_str());
         frameCount = 0;
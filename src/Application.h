@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <chrono>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -15,6 +16,7 @@
 #include "Renderer.h"
 #include "DebugDrawer.h"
 #include "Texture2D.h"
+#include "TextureArray.h"
 #include "Mesh.h"
 
 class Application {
@@ -51,6 +53,8 @@ private:
 
     // Timing
     double m_lastTime = 0.0;
+    std::chrono::steady_clock::time_point m_startTime;
+    bool m_firstFrameReported = false;
 
     // Enderman
     double m_endermanTeleportTimer = 0.0;
@@ -65,7 +69,7 @@ private:
     // Resources
     std::map<std::string, std::unique_ptr<Mesh>> m_meshCache;
     std::map<std::string, std::unique_ptr<Texture2D>> m_modelTextureCache;
-    std::unique_ptr<Texture2D[]> m_blockTextures;
+    std::unique_ptr<TextureArray> m_blockTextures;
 
     // Systems
     std::unique_ptr<Renderer> m_renderer;
@@ -83,4 +87,5 @@ private:
     static void onFramebufferSize(GLFWwindow* window, int width, int height);
 
     void showFPS();
+    void runEditBenchmark();
 };
\ No newline at end of file
@@ -17,6 +17,8 @@ enum class BlockType {
 	GLASS,
 	HUD,
 	HUD_SELECTED,
+
+	COUNT // Number of block types, keep last
 };
 
 struct BlockTexturePaths {
@@ -36,6 +38,7 @@ struct CubeVertex {
 	glm::vec3 position;
 	glm::vec3 normal;
 	glm::vec3 texCoords;
+	unsigned int light = 0; // Baked lighting, see Chunk::packVertexLight
 };
 
 struct RaycastHit {
@@ -0,0 +1,135 @@
+#include "BlockRegistry.h"
+#include <stdexcept>
+
+namespace {
+        const BlockMaterial DEFAULT_MATERIAL = {glm::vec3(1.0f), glm::vec3(0.1f), 8.0f};
+        const BlockMaterial SHINY_MATERIAL = {glm::vec3(1.0f), glm::vec3(0.8f), 64.0f}; // e.g. for Glass
+        const BlockMaterial MATTE_MATERIAL = {glm::vec3(1.0f), glm::vec3(0.05f), 0.0f}; // e.g. for Leaves
+
+        // type, name, shape, opaque, collision, cutout, castsShadow, emission, textures (top, bottom, side, special), material, light (creator, offset, scale)
+        const BlockDefinition BLOCK_DEFINITIONS[] = {
+                { BlockType::AIR, "air", BlockShape::NONE, false, false, false, false, 0,
+                  { "", "", "", "" }, DEFAULT_MATERIAL, nullptr, glm::vec3(0.0f), 0.0f },
+                { BlockType::GRASS, "grass", BlockShape::CUBE, true, true, false, true, 0,
+                  { "./textures/grass-top.jpg", "./textures/dirt.png", "./textures/grass-side.png", "" }, DEFAULT_MATERIAL, nullptr, glm::vec3(0.0f), 0.0f },
+                { BlockType::DIRT, "dirt", BlockShape::CUBE, true, true, false, true, 0,
+                  { "./textures/dirt.png", "./textures/dirt.png", "./textures/dirt.png", "" }, DEFAULT_MATERIAL, nullptr, glm::vec3(0.0f), 0.0f },
+                { BlockType::STONE, "stone", BlockShape::CUBE, true, true, false, true, 0,
+                  { "./textures/stone.png", "./textures/stone.png", "./textures/stone.png", "" }, DEFAULT_MATERIAL, nullptr, glm::vec3(0.0f), 0.0f },
+                // Redstone light is baked into chunk vertices by default; its point light is only used in dynamic mode.
+                // The block is opaque, so the light sits just above it; it stands in for one light per open face.
+                { BlockType::REDSTONE, "redstone", BlockShape::CUBE, true, true, false, false, 7,
+                  { "./textures/redstone.png", "./textures/redstone.png", "./textures/redstone.png", "" }, SHINY_MATERIAL,
+                  CreateRedstoneLight, glm::vec3(0.0f, 1.01f, 0.0f), 5.0f },
+                { BlockType::WOOD, "wood", BlockShape::CUBE, true, true, false, true, 0,
+                  { "./textures/wood-top.png", "./textures/wood-top.png", "./textures/wood-side.png", "" }, SHINY_MATERIAL, nullptr, glm::vec3(0.0f), 0.0f },
+                { BlockType::LEAVES, "leaves", BlockShape::CUBE, false, true, true, true, 0,
+                  { "./textures/leaves.png", "./textures/leaves.png", "./textures/leaves.png", "" }, MATTE_MATERIAL, nullptr, glm::vec3(0.0f), 0.0f },
+                { BlockType::TORCH, "torch", BlockShape::TORCH, false, false, false, false, 14,
+                  { "", "", "", "./textures/torch.png" }, SHINY_MATERIAL,
+                  CreateTorchLight, glm::vec3(0.0f, 0.2f, 0.0f), 4.0f },
+                { BlockType::GLASS, "glass", BlockShape::CUBE, false, true, true, true, 0,
+                  { "./textures/glass.png", "./textures/glass.png", "./textures/glass.png", "" }, SHINY_MATERIAL, nullptr, glm::vec3(0.0f), 0.0f },
+                { BlockType::HUD, "hud", BlockShape::NONE, false, false, false, false, 0,
+                  { "", "", "", "./textures/hud1.png" }, DEFAULT_MATERIAL, nullptr, glm::vec3(0.0f), 0.0f },
+                { BlockType::HUD_SELECTED, "hud_selected", BlockShape::NONE, false, false, false, false, 0,
+                  { "", "", "", "./textures/hud2.png" }, DEFAULT_MATERIAL, nullptr, glm::vec3(0.0f), 0.0f },
+        };
+}
+
+bool BlockRegistry::m_initialized = false;
+std::array<const BlockDefinition*, BlockRegistry::BLOCK_TYPE_COUNT> BlockRegistry::m_definitions;
+std::array<BlockShape, BlockRegistry::BLOCK_TYPE_COUNT> BlockRegistry::m_shape;
+std::array<bool, BlockRegistry::BLOCK_TYPE_COUNT> BlockRegistry::m_opaque;
+std::array<bool, BlockRegistry::BLOCK_TYPE_COUNT> BlockRegistry::m_collision;
+std::array<int, BlockRegistry::BLOCK_TYPE_COUNT> BlockRegistry::m_emission;
+std::array<std::array<int, FACE_COUNT>, BlockRegistry::BLOCK_TYPE_COUNT> BlockRegistry::m_faceLayers;
+std::array<int, BlockRegistry::BLOCK_TYPE_COUNT> BlockRegistry::m_iconLayer;
+std::array<BlockMaterial, BlockRegistry::BLOCK_TYPE_COUNT> BlockRegistry::m_material;
+std::vector<std::string> BlockRegistry::m_layerPaths;
+std::vector<BlockMaterial> BlockRegistry::m_layerMaterials;
+std::vector<int> BlockRegistry::m_layerFlags;
+unsigned int BlockRegistry::m_materialVersion = 0;
+
+int BlockRegistry::registerLayer(const std::string& path) {
+        if (path.empty()) return -1;
+
+        for (size_t i = 0; i < m_layerPaths.size(); i++) {
+                if (m_layerPaths[i] == path) return (int)i;
+        }
+
+        m_layerPaths.push_back(path);
+        m_layerFlags.push_back(0);
+        return (int)m_layerPaths.size() - 1;
+}
+
+void BlockRegistry::init() {
+        if (m_initialized) return;
+
+        m_definitions.fill(nullptr);
+        for (const auto& def : BLOCK_DEFINITIONS) {
+                m_definitions[index(def.type)] = &def;
+        }
+
+        for (int i = 0; i < BLOCK_TYPE_COUNT; i++) {
+                if (!m_definitions[i]) {
+                        throw std::runtime_error("BlockRegistry: block type " + std::to_string(i) + " has no definition");
+                }
+        }
+
+        for (int i = 0; i < BLOCK_TYPE_COUNT; i++) {
+                const BlockDefinition& def = *m_definitions[i];
+
+                m_shape[i] = def.shape;
+                m_opaque[i] = def.opaque;
+                m_collision[i] = def.collision;
+                m_emission[i] = def.emission;
+                m_material[i] = def.material;
+
+                // A face without its own texture falls back to the special one (torch, HUD)
+                const BlockTexturePaths& tex = def.textures;
+                auto facePath = [&](const std::string& path) -> const std::string& {
+                        return path.empty() ? tex.special : path;
+                };
+                int top = registerLayer(facePath(tex.top));
+                int bottom = registerLayer(facePath(tex.bottom));
+                int side = registerLayer(facePath(tex.side));
+                registerLayer(tex.special);
+
+                m_faceLayers[i] = { side, side, top, bottom, side, side };
+                m_iconLayer[i] = tex.special.empty() ? top : registerLayer(tex.special);
+
+                int flags = 0;
+                if (def.cutout) flags |= LAYER_CUTOUT;
+                if (!def.castsShadow && def.shape != BlockShape::NONE) flags |= LAYER_NO_SHADOW;
+
+                for (int layer : m_faceLayers[i]) {
+                        if (layer < 0 || def.shape == BlockShape::NONE) continue;
+                        m_layerFlags[layer] |= flags;
+                }
+        }
+
+        rebuildLayerMaterials();
+        m_initialized = true;
+}
+
+void BlockRegistry::rebuildLayerMaterials() {
+        m_layerMaterials.assign(m_layerPaths.size(), DEFAULT_MATERIAL);
+
+        for (int i = 0; i < BLOCK_TYPE_COUNT; i++) {
+                if (m_shape[i] == BlockShape::NONE) continue;
+
+                for (int layer : m_faceLayers[i]) {
+                        if (layer >= 0) m_layerMaterials[layer] = m_material[i];
+                }
+        }
+
+        m_materialVersion++;
+}
+
+bool BlockRegistry::anyLayerHasFlags(int flags) {
+        for (int layerFlags : m_layerFlags) {
+                if ((layerFlags & flags) != 0) return true;
+        }
+        return false;
+}
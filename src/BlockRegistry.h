@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Block.h"
+#include "Light.h"
+
+enum class BlockShape : unsigned char {
+	NONE,   // Not meshed (air, GUI-only entries)
+	CUBE,
+	TORCH,
+};
+
+// Block faces by outward normal, used to look up a face's texture layer
+enum BlockFace {
+	FACE_POS_X,
+	FACE_NEG_X,
+	FACE_POS_Y,
+	FACE_NEG_Y,
+	FACE_POS_Z,
+	FACE_NEG_Z,
+	FACE_COUNT
+};
+
+// Per-layer flags consumed by the depth shaders
+enum LayerFlags {
+	LAYER_CUTOUT = 1 << 0,    // Alpha-tested texture
+	LAYER_NO_SHADOW = 1 << 1, // Never written to shadow maps
+};
+
+// One row of the block table. Adding a block type only needs a new enum value and a row.
+struct BlockDefinition {
+	BlockType type;
+	const char* name;
+	BlockShape shape;
+	bool opaque;      // Hides the faces of the blocks next to it
+	bool collision;
+	bool cutout;
+	bool castsShadow;
+	int emission;     // Block light level, 0..15
+	BlockTexturePaths textures;
+	BlockMaterial material;
+
+	// One point light per emitter, at lightOffset from the block center and with its colour scaled
+	// by lightScale. Opaque emitters must place it outside their own block.
+	PointLight (*createLight)(const glm::vec3& position);
+	glm::vec3 lightOffset;
+	float lightScale;
+};
+
+class BlockRegistry {
+public:
+	static const int BLOCK_TYPE_COUNT = (int)BlockType::COUNT;
+
+	// Builds the dense per-type and per-layer tables. Safe to call more than once.
+	static void init();
+
+	static const BlockDefinition& get(BlockType type) { return *m_definitions[index(type)]; }
+
+	static BlockShape getShape(BlockType type) { return m_shape[index(type)]; }
+	static bool isOpaque(BlockType type) { return m_opaque[index(type)]; }
+	static bool hasCollision(BlockType type) { return m_collision[index(type)]; }
+	static int getEmission(BlockType type) { return m_emission[index(type)]; }
+	static int getFaceLayer(BlockType type, BlockFace face) { return m_faceLayers[index(type)][face]; }
+	static int getIconLayer(BlockType type) { return m_iconLayer[index(type)]; }
+
+	// Texture layers, in the order they must be uploaded
+	static int getLayerCount() { return (int)m_layerPaths.size(); }
+	static const std::vector<std::string>& getLayerPaths() { return m_layerPaths; }
+	static const BlockMaterial& getLayerMaterial(int layer) { return m_layerMaterials[layer]; }
+	static int getLayerFlags(int layer) { return m_layerFlags[layer]; }
+	static bool anyLayerHasFlags(int flags);
+
+	// Bumped whenever the per-layer material table changes so GPU copies know to re-upload
+	static unsigned int getMaterialVersion() { return m_materialVersion; }
+
+private:
+	static int index(BlockType type) { return (int)type; }
+	static int registerLayer(const std::string& path);
+	static void rebuildLayerMaterials();
+
+	static bool m_initialized;
+	static std::array<const BlockDefinition*, BLOCK_TYPE_COUNT> m_definitions;
+	static std::array<BlockShape, BLOCK_TYPE_COUNT> m_shape;
+	static std::array<bool, BLOCK_TYPE_COUNT> m_opaque;
+	static std::array<bool, BLOCK_TYPE_COUNT> m_collision;
+	static std::array<int, BLOCK_TYPE_COUNT> m_emission;
+	static std::array<std::array<int, FACE_COUNT>, BLOCK_TYPE_COUNT> m_faceLayers;
+	static std::array<int, BLOCK_TYPE_COUNT> m_iconLayer;
+	static std::array<BlockMaterial, BLOCK_TYPE_COUNT> m_material;
+
+	static std::vector<std::string> m_layerPaths;
+	static std::vector<BlockMaterial> m_layerMaterials;
+	static std::vector<int> m_layerFlags;
+	static unsigned int m_materialVersion;
+};
@@ -1,4 +1,5 @@
 #include "Camera.h"
+#include "BlockRegistry.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include "glm/gtc/constants.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -93,7 +94,7 @@ void FPSCamera::jump() {
 
 void FPSCamera::applyPhysics(World& world, double elapsedTime) {
     const auto isBlocked = [&](const glm::vec3& pos) {
-        return world.getBlockAt(pos) != BlockType::AIR && world.getBlockAt(pos) != BlockType::TORCH;
+        return BlockRegistry::hasCollision(world.getBlockAt(pos));
     };
 
     const float GRAVITY = 20.0f;
@@ -1,30 +1,35 @@
 #include "Chunk.h"
+#include "GLState.h"
+#include "BlockRegistry.h"
 #include <iostream>
+#include <algorithm>
+#include <bitset>
 #include <cmath>
 #include <random>
 
-std::map<BlockType, BlockTexturePaths> Chunk::m_textureConfig;
-std::map<BlockType, BlockMaterial> Chunk::m_materialConfig;
-std::map<std::string, int> Chunk::m_pathToTextureIndex;
-int Chunk::m_nextTextureIndex = 0;
+bool Chunk::sAmbientOcclusion = true;
 
 Chunk::Chunk(int chunkX, int chunkZ)
-: mChunkX(chunkX), mChunkZ(chunkZ), mVAO(0), mVBO(0), mVertexCount(0) {
-        if (m_textureConfig.empty()) {
-                initializeTextureConfig();
-        }
+: mChunkX(chunkX), mChunkZ(chunkZ) {
         for (int x = 0; x < CHUNK_SIZE; x++) {
                 for (int y = 0; y < CHUNK_HEIGHT; y++) {
                         for (int z = 0; z < CHUNK_SIZE; z++) {
                                 mBlocks[x][y][z] = BlockType::AIR;
+                                mLight[LIGHT_BLOCK][x][y][z] = 0;
+                                mLight[LIGHT_SKY][x][y][z] = 0;
                         }
                 }
+                for (int z = 0; z < CHUNK_SIZE; z++) {
+                        mHeightMap[x][z] = 0;
+                }
         }
 }
 
 Chunk::~Chunk() {
-        glDeleteVertexArrays(1, &mVAO);
-        glDeleteBuffers(1, &mVBO);
+        for (auto& section : mSections) {
+                GLState::deleteVertexArrays(1, &section.vao);
+                glDeleteBuffers(1, &section.vbo);
+        }
 }
 
 void Chunk::generate(long long worldSeed) {
@@ -133,6 +138,18 @@ void Chunk::generate(long long worldSeed) {
                         }
                 }
         }
+
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+                for (int z = 0; z < CHUNK_SIZE; z++) {
+                        updateHeight(x, z);
+                }
+        }
+}
+
+void Chunk::updateHeight(int x, int z) {
+        int y = CHUNK_HEIGHT;
+        while (y > 0 && !BlockRegistry::isOpaque(mBlocks[x][y - 1][z])) y--;
+        mHeightMap[x][z] = y;
 }
 
 BlockType Chunk::getBlock(int x, int y, int z) const {
@@ -142,146 +159,78 @@ BlockType Chunk::getBlock(int x, int y, int z) const {
         return mBlocks[x][y][z];
 }
 
-void Chunk::initializeTextureConfig() {
-        auto getIndex = [](const std::string& path) -> int {
-                if (m_pathToTextureIndex.find(path) == m_pathToTextureIndex.end()) {
-                        m_pathToTextureIndex[path] = m_nextTextureIndex++;
-                }
-                return m_pathToTextureIndex[path];
-        };
-
-        m_textureConfig[BlockType::GRASS] = {
-                "./textures/grass-top.jpg",   // Top
-                "./textures/dirt.png",        // Bottom
-                "./textures/grass-side.png",  // Side
-                ""
-        };
-
-        m_textureConfig[BlockType::WOOD] = {
-                "./textures/wood-top.png",
-                "./textures/wood-top.png",
-                "./textures/wood-side.png",
-                ""
-        };
-
-        m_textureConfig[BlockType::DIRT] = {
-                "./textures/dirt.png",
-                "./textures/dirt.png",
-                "./textures/dirt.png",
-                ""
-        };
-
-        m_textureConfig[BlockType::STONE] = {
-                "./textures/stone.png",
-                "./textures/stone.png",
-                "./textures/stone.png",
-                ""
-        };
-
-        m_textureConfig[BlockType::REDSTONE] = {
-                "./textures/redstone.png",
-                "./textures/redstone.png",
-                "./textures/redstone.png",
-                ""
-        };
-
-        m_textureConfig[BlockType::LEAVES] = {
-                "./textures/leaves.png",
-                "./textures/leaves.png",
-                "./textures/leaves.png",
-                ""
-        };
-
-        m_textureConfig[BlockType::TORCH] = {
-                "", "", "",
-                "./textures/torch.png"
-        };
-
-        m_textureConfig[BlockType::GLASS] = {
-                "./textures/glass.png",
-                "./textures/glass.png",
-                "./textures/glass.png",
-                ""
-        };
-
-        m_textureConfig[BlockType::HUD] = {
-                "",
-                "",
-                "",
-                "./textures/hud1.png"
-        };
-
-        m_textureConfig[BlockType::HUD_SELECTED] = {
-                "",
-                "",
-                "",
-                "./textures/hud2.png"
-        };
-
-        for (const auto& pair : m_textureConfig) {
-                if (!pair.second.top.empty()) getIndex(pair.second.top);
-                if (!pair.second.bottom.empty()) getIndex(pair.second.bottom);
-                if (!pair.second.side.empty()) getIndex(pair.second.side);
-                if (!pair.second.special.empty()) getIndex(pair.second.special);
-        }
-
-        BlockMaterial defaultMat = {glm::vec3(1.0f), glm::vec3(0.1f), 8.0f};
-        BlockMaterial shinyMat = {glm::vec3(1.0f), glm::vec3(0.8f), 64.0f}; // e.g. for Glass
-        BlockMaterial matteMat = {glm::vec3(1.0f), glm::vec3(0.05f), 0.0f}; // e.g. for Leaves
-
-        m_materialConfig[BlockType::GRASS] = defaultMat;
-        m_materialConfig[BlockType::DIRT] = defaultMat;
-        m_materialConfig[BlockType::STONE] = defaultMat;
-        m_materialConfig[BlockType::WOOD] = shinyMat;
-        m_materialConfig[BlockType::REDSTONE] = shinyMat; // Redstone light is handled by point lights
-        m_materialConfig[BlockType::LEAVES] = matteMat;
-        m_materialConfig[BlockType::TORCH] = shinyMat;
-        m_materialConfig[BlockType::GLASS] = shinyMat;
-}
-
 void Chunk::setBlock(int x, int y, int z, BlockType type) {
         if (x >= 0 && x < CHUNK_SIZE && y >= 0 && y < CHUNK_HEIGHT && z >= 0 && z < CHUNK_SIZE) {
                 mBlocks[x][y][z] = type;
+                mSections[y / SECTION_HEIGHT].connectivityDirty = true;
+                mOccludersDirty = true;
+
+                if (BlockRegistry::isOpaque(type)) {
+                        if (y >= mHeightMap[x][z]) mHeightMap[x][z] = y + 1;
+                } else if (y == mHeightMap[x][z] - 1) {
+                        updateHeight(x, z);
+                }
         }
 }
 
-bool isSolidBlock(BlockType type) {
-        return type != BlockType::AIR;
+int Chunk::getLight(LightChannel channel, int x, int y, int z) const {
+        if (y >= CHUNK_HEIGHT) {
+                return channel == LIGHT_SKY ? MAX_LIGHT_LEVEL : 0;
+        }
+        if (x < 0 || x >= CHUNK_SIZE || y < 0 || z < 0 || z >= CHUNK_SIZE) {
+                return 0;
+        }
+        return mLight[channel][x][y][z];
 }
 
-bool isFullBlock(BlockType type) {
-        if (type == BlockType::TORCH) return false;
-        return type != BlockType::AIR;
+int Chunk::sampleLight(LightChannel channel, int x, int y, int z) const {
+        // Faces on the edge of the loaded world look out into open sky
+        int missing = channel == LIGHT_SKY ? MAX_LIGHT_LEVEL : 0;
+        if (x < 0) return mNeighbours[SIDE_NEG_X] ? mNeighbours[SIDE_NEG_X]->getLight(channel, x + CHUNK_SIZE, y, z) : missing;
+        if (x >= CHUNK_SIZE) return mNeighbours[SIDE_POS_X] ? mNeighbours[SIDE_POS_X]->getLight(channel, x - CHUNK_SIZE, y, z) : missing;
+        if (z < 0) return mNeighbours[SIDE_NEG_Z] ? mNeighbours[SIDE_NEG_Z]->getLight(channel, x, y, z + CHUNK_SIZE) : missing;
+        if (z >= CHUNK_SIZE) return mNeighbours[SIDE_POS_Z] ? mNeighbours[SIDE_POS_Z]->getLight(channel, x, y, z - CHUNK_SIZE) : missing;
+        return getLight(channel, x, y, z);
 }
 
-bool shouldRenderFace(const Chunk* chunk, int x, int y, int z, int nx, int ny, int nz) {
-        BlockType neighbor = chunk->getBlock(x + nx, y + ny, z + nz);
+BlockType Chunk::sampleBlock(int x, int y, int z) const {
+        if (x < 0) return mNeighbours[SIDE_NEG_X] ? mNeighbours[SIDE_NEG_X]->sampleBlock(x + CHUNK_SIZE, y, z) : BlockType::AIR;
+        if (x >= CHUNK_SIZE) return mNeighbours[SIDE_POS_X] ? mNeighbours[SIDE_POS_X]->sampleBlock(x - CHUNK_SIZE, y, z) : BlockType::AIR;
+        if (z < 0) return mNeighbours[SIDE_NEG_Z] ? mNeighbours[SIDE_NEG_Z]->sampleBlock(x, y, z + CHUNK_SIZE) : BlockType::AIR;
+        if (z >= CHUNK_SIZE) return mNeighbours[SIDE_POS_Z] ? mNeighbours[SIDE_POS_Z]->sampleBlock(x, y, z - CHUNK_SIZE) : BlockType::AIR;
+        return getBlock(x, y, z);
+}
 
-        // Don't render if neighbor is a full block (except for leaves and glass)
-        if (isFullBlock(neighbor) && neighbor != BlockType::LEAVES && neighbor != BlockType::GLASS) {
-                return false;
-        }
+void Chunk::computeFaceAO(int x, int y, int z, const glm::ivec3& normal, const glm::vec3 cornerOffsets[4], int ao[4]) const {
+        // The occluders sit in the layer of voxels the face looks into
+        glm::ivec3 layer = glm::ivec3(x, y, z) + normal;
+        auto occludes = [&](const glm::ivec3& p) {
+                return BlockRegistry::isOpaque(sampleBlock(p.x, p.y, p.z));
+        };
 
-        return true;
-}
+        for (int corner = 0; corner < 4; corner++) {
+                // Step towards the corner along the two axes tangent to the face
+                glm::ivec3 toCorner = glm::ivec3(glm::sign(cornerOffsets[corner])) * (glm::ivec3(1) - glm::abs(normal));
+                glm::ivec3 side1 = toCorner, side2 = toCorner;
+                if (normal.x != 0) { side1.z = 0; side2.y = 0; }
+                else if (normal.y != 0) { side1.z = 0; side2.x = 0; }
+                else { side1.y = 0; side2.x = 0; }
 
-glm::vec3 getTextureCoords(BlockType type, const glm::vec3& normal, int corner) {
-        std::string path = "";
-        if (Chunk::m_textureConfig.count(type)) {
-                const auto& config = Chunk::m_textureConfig.at(type);
+                bool s1 = occludes(layer + side1);
+                bool s2 = occludes(layer + side2);
+                bool c = occludes(layer + toCorner);
 
-                if (glm::abs(normal.y) > 0.5f) {
-                        path = (normal.y > 0.5f) ? config.top : config.bottom;
-                } else {
-                        path = config.side;
-                }
+                // Two sides already hide the corner voxel completely
+                ao[corner] = (s1 && s2) ? 0 : MAX_AO_LEVEL - ((int)s1 + (int)s2 + (int)c);
         }
+}
 
-        int textureIndex = -1;
-        if (Chunk::m_pathToTextureIndex.count(path) && path != "") {
-                textureIndex = Chunk::m_pathToTextureIndex.at(path);
-        }
+bool shouldRenderFace(const Chunk* chunk, int x, int y, int z, int nx, int ny, int nz) {
+        // Only opaque neighbours hide a face; leaves, glass and torches let it show through
+        return !BlockRegistry::isOpaque(chunk->getBlock(x + nx, y + ny, z + nz));
+}
 
+glm::vec3 getTextureCoords(int layer, int corner) {
         glm::vec2 uv;
         switch (corner) {
                 case 0: uv = glm::vec2(0.0f, 0.0f); break;
@@ -291,63 +240,67 @@ glm::vec3 getTextureCoords(BlockType type, const glm::vec3& normal, int corner)
                 default: uv = glm::vec2(0.0f, 0.0f); break;
         }
 
-        return glm::vec3(uv.x, uv.y, (float)textureIndex);
+        return glm::vec3(uv.x, uv.y, (float)layer);
 }
 
-void addFace(std::vector<CubeVertex>& vertices, int chunkX, int chunkZ, int x, int y, int z, const glm::vec3& normal, BlockType type) {
-    glm::vec3 chunkWorldPos = glm::vec3(chunkX * Chunk::CHUNK_SIZE, 0, chunkZ * Chunk::CHUNK_SIZE);
-    glm::vec3 worldPos = chunkWorldPos + glm::vec3(x, y, z);
-
-    glm::vec3 corners[4];
-
+void getFaceCorners(const glm::vec3& normal, glm::vec3 corners[4]) {
+    // Offsets from the block center, counter-clockwise seen from outside
     if (normal.z > 0.5f) { // Front (+Z)
-        corners[0] = worldPos + glm::vec3(-0.5f, -0.5f,  0.5f);
-        corners[1] = worldPos + glm::vec3( 0.5f, -0.5f,  0.5f);
-        corners[2] = worldPos + glm::vec3( 0.5f,  0.5f,  0.5f);
-        corners[3] = worldPos + glm::vec3(-0.5f,  0.5f,  0.5f);
+        corners[0] = glm::vec3(-0.5f, -0.5f,  0.5f);
+        corners[1] = glm::vec3( 0.5f, -0.5f,  0.5f);
+        corners[2] = glm::vec3( 0.5f,  0.5f,  0.5f);
+        corners[3] = glm::vec3(-0.5f,  0.5f,  0.5f);
     } else if (normal.z < -0.5f) { // Back (-Z)
-        corners[0] = worldPos + glm::vec3( 0.5f, -0.5f, -0.5f);
-        corners[1] = worldPos + glm::vec3(-0.5f, -0.5f, -0.5f);
-        corners[2] = worldPos + glm::vec3(-0.5f,  0.5f, -0.5f);
-        corners[3] = worldPos + glm::vec3( 0.5f,  0.5f, -0.5f);
+        corners[0] = glm::vec3( 0.5f, -0.5f, -0.5f);
+        corners[1] = glm::vec3(-0.5f, -0.5f, -0.5f);
+        corners[2] = glm::vec3(-0.5f,  0.5f, -0.5f);
+        corners[3] = glm::vec3( 0.5f,  0.5f, -0.5f);
     } else if (normal.y > 0.5f) { // Top (+Y)
-        corners[0] = worldPos + glm::vec3(-0.5f,  0.5f,  0.5f);
-        corners[1] = worldPos + glm::vec3( 0.5f,  0.5f,  0.5f);
-        corners[2] = worldPos + glm::vec3( 0.5f,  0.5f, -0.5f);
-        corners[3] = worldPos + glm::vec3(-0.5f,  0.5f, -0.5f);
+        corners[0] = glm::vec3(-0.5f,  0.5f,  0.5f);
+        corners[1] = glm::vec3( 0.5f,  0.5f,  0.5f);
+        corners[2] = glm::vec3( 0.5f,  0.5f, -0.5f);
+        corners[3] = glm::vec3(-0.5f,  0.5f, -0.5f);
     } else if (normal.y < -0.5f) { // Bottom (-Y)
-        corners[0] = worldPos + glm::vec3(-0.5f, -0.5f, -0.5f);
-        corners[1] = worldPos + glm::vec3( 0.5f, -0.5f, -0.5f);
-        corners[2] = worldPos + glm::vec3( 0.5f, -0.5f,  0.5f);
-        corners[3] = worldPos + glm::vec3(-0.5f, -0.5f,  0.5f);
+        corners[0] = glm::vec3(-0.5f, -0.5f, -0.5f);
+        corners[1] = glm::vec3( 0.5f, -0.5f, -0.5f);
+        corners[2] = glm::vec3( 0.5f, -0.5f,  0.5f);
+        corners[3] = glm::vec3(-0.5f, -0.5f,  0.5f);
     } else if (normal.x > 0.5f) { // Right (+X)
-        corners[0] = worldPos + glm::vec3( 0.5f, -0.5f,  0.5f);
-        corners[1] = worldPos + glm::vec3( 0.5f, -0.5f, -0.5f);
-        corners[2] = worldPos + glm::vec3( 0.5f,  0.5f, -0.5f);
-        corners[3] = worldPos + glm::vec3( 0.5f,  0.5f,  0.5f);
+        corners[0] = glm::vec3( 0.5f, -0.5f,  0.5f);
+        corners[1] = glm::vec3( 0.5f, -0.5f, -0.5f);
+        corners[2] = glm::vec3( 0.5f,  0.5f, -0.5f);
+        corners[3] = glm::vec3( 0.5f,  0.5f,  0.5f);
     } else { // Left (-X)
-        corners[0] = worldPos + glm::vec3(-0.5f, -0.5f, -0.5f);
-        corners[1] = worldPos + glm::vec3(-0.5f, -0.5f,  0.5f);
-        corners[2] = worldPos + glm::vec3(-0.5f,  0.5f,  0.5f);
-        corners[3] = worldPos + glm::vec3(-0.5f,  0.5f, -0.5f);
+        corners[0] = glm::vec3(-0.5f, -0.5f, -0.5f);
+        corners[1] = glm::vec3(-0.5f, -0.5f,  0.5f);
+        corners[2] = glm::vec3(-0.5f,  0.5f,  0.5f);
+        corners[3] = glm::vec3(-0.5f,  0.5f, -0.5f);
     }
+}
 
-    // Triangle 1: corners 0, 1, 2
-    CubeVertex v0, v1, v2;
-    v0.position = corners[0]; v0.normal = normal; v0.texCoords = getTextureCoords(type, normal, 0);
-    v1.position = corners[1]; v1.normal = normal; v1.texCoords = getTextureCoords(type, normal, 1);
-    v2.position = corners[2]; v2.normal = normal; v2.texCoords = getTextureCoords(type, normal, 2);
-    vertices.push_back(v0); vertices.push_back(v1); vertices.push_back(v2);
-
-    // Triangle 2: corners 0, 2, 3
-    CubeVertex v3, v4, v5;
-    v3.position = corners[0]; v3.normal = normal; v3.texCoords = getTextureCoords(type, normal, 0);
-    v4.position = corners[2]; v4.normal = normal; v4.texCoords = getTextureCoords(type, normal, 2);
-    v5.position = corners[3]; v5.normal = normal; v5.texCoords = getTextureCoords(type, normal, 3);
-    vertices.push_back(v3); vertices.push_back(v4); vertices.push_back(v5);
+void addFace(std::vector<CubeVertex>& vertices, int chunkX, int chunkZ, int x, int y, int z, const glm::vec3& normal, int layer,
+             const glm::vec3 cornerOffsets[4], int blockLight, int skyLight, const int ao[4]) {
+    glm::vec3 chunkWorldPos = glm::vec3(chunkX * Chunk::CHUNK_SIZE, 0, chunkZ * Chunk::CHUNK_SIZE);
+    glm::vec3 worldPos = chunkWorldPos + glm::vec3(x, y, z);
+
+    // Split along the brighter diagonal: AO interpolated across the other one shows up as a
+    // crease whose direction depends on the quad's orientation
+    static const int DIAGONAL_02[6] = { 0, 1, 2, 0, 2, 3 };
+    static const int DIAGONAL_13[6] = { 1, 2, 3, 1, 3, 0 };
+    const int* order = (ao[0] + ao[2] >= ao[1] + ao[3]) ? DIAGONAL_02 : DIAGONAL_13;
+
+    for (int i = 0; i < 6; i++) {
+        int corner = order[i];
+        CubeVertex v;
+        v.position = worldPos + cornerOffsets[corner];
+        v.normal = normal;
+        v.texCoords = getTextureCoords(layer, corner);
+        v.light = Chunk::packVertexLight(blockLight, skyLight, ao[corner]);
+        vertices.push_back(v);
+    }
 }
 
-void addTorchMesh(std::vector<CubeVertex>& vertices, int chunkX, int chunkZ, int x, int y, int z) {
+void addTorchMesh(std::vector<CubeVertex>& vertices, int chunkX, int chunkZ, int x, int y, int z, unsigned int light) {
     glm::vec3 chunkWorldPos = glm::vec3(chunkX * Chunk::CHUNK_SIZE, 0, chunkZ * Chunk::CHUNK_SIZE);
     glm::vec3 blockCenterWorld = chunkWorldPos + glm::vec3(x, y, z); // Centre du bloc (x, y, z)
 
@@ -357,12 +310,7 @@ void addTorchMesh(std::vector<CubeVertex>& vertices, int chunkX, int chunkZ, int
     const float Y_MIN = -0.5f;    // Bas du voxel
     const float Y_MAX = -0.5f + 0.75f; // 5/8 de la hauteur du bloc, partant du bas
 
-    int textureIndex = -1;
-    const auto& config = Chunk::m_textureConfig.at(BlockType::TORCH);
-    if (Chunk::m_pathToTextureIndex.count(config.special)) {
-        textureIndex = Chunk::m_pathToTextureIndex.at(config.special);
-    }
-    float texIdx = (float)textureIndex;
+    float texIdx = (float)BlockRegistry::getFaceLayer(BlockType::TORCH, FACE_POS_Y);
 
     // Fonction utilitaire pour obtenir les coordonnées de texture (u, v, textureIndex)
     auto getTorchTexCoords = [&](int corner) -> glm::vec3 {
@@ -380,13 +328,13 @@ void addTorchMesh(std::vector<CubeVertex>& vertices, int chunkX, int chunkZ, int
     // Fonction utilitaire pour ajouter une face (2 triangles: c0, c1, c2 puis c0, c2, c3)
     auto addCubeFace = [&](const glm::vec3& c0, const glm::vec3& c1, const glm::vec3& c2, const glm::vec3& c3, const glm::vec3& normal) {
         // Triangle 1: c0 (0), c1 (1), c2 (2)
-        vertices.push_back({blockCenterWorld + c0, normal, getTorchTexCoords(0)});
-        vertices.push_back({blockCenterWorld + c1, normal, getTorchTexCoords(1)});
-        vertices.push_back({blockCenterWorld + c2, normal, getTorchTexCoords(2)});
+        vertices.push_back({blockCenterWorld + c0, normal, getTorchTexCoords(0), light});
+        vertices.push_back({blockCenterWorld + c1, normal, getTorchTexCoords(1), light});
+        vertices.push_back({blockCenterWorld + c2, normal, getTorchTexCoords(2), light});
         // Triangle 2: c0 (0), c2 (2), c3 (3)
-        vertices.push_back({blockCenterWorld + c0, normal, getTorchTexCoords(0)});
-        vertices.push_back({blockCenterWorld + c2, normal, getTorchTexCoords(2)});
-        vertices.push_back({blockCenterWorld + c3, normal, getTorchTexCoords(3)});
+        vertices.push_back({blockCenterWorld + c0, normal, getTorchTexCoords(0), light});
+        vertices.push_back({blockCenterWorld + c2, normal, getTorchTexCoords(2), light});
+        vertices.push_back({blockCenterWorld + c3, normal, getTorchTexCoords(3), light});
     };
 
     // --- 1. Face du Bas (-Y) ---
@@ -453,91 +401,219 @@ void addTorchMesh(std::vector<CubeVertex>& vertices, int chunkX, int chunkZ, int
 }
 
 void Chunk::buildMesh() {
+        for (int section = 0; section < SECTION_COUNT; section++) {
+                buildSectionMesh(section);
+        }
+}
+
+namespace {
+        struct FaceDirection {
+                int dx, dy, dz;
+                BlockFace face;
+        };
+
+        const FaceDirection FACE_DIRECTIONS[] = {
+                { 0,  0,  1, FACE_POS_Z },
+                { 0,  0, -1, FACE_NEG_Z },
+                { 0,  1,  0, FACE_POS_Y },
+                { 0, -1,  0, FACE_NEG_Y },
+                { 1,  0,  0, FACE_POS_X },
+                {-1,  0,  0, FACE_NEG_X },
+        };
+}
+
+void Chunk::buildSectionMesh(int section) {
+        if (section < 0 || section >= SECTION_COUNT) return;
+
+        if (mSections[section].connectivityDirty) {
+                updateSectionConnectivity(section);
+        }
+        if (mOccludersDirty) {
+                updateOccluders();
+        }
+
         mVertices.clear();
 
+        const int yBegin = section * SECTION_HEIGHT;
+        const int yEnd = yBegin + SECTION_HEIGHT;
+
         for (int x = 0; x < CHUNK_SIZE; x++) {
-                for (int y = 0; y < CHUNK_HEIGHT; y++) {
+                for (int y = yBegin; y < yEnd; y++) {
                         for (int z = 0; z < CHUNK_SIZE; z++) {
                                 BlockType type = getBlock(x, y, z);
-                                if (type == BlockType::AIR) continue;
+                                BlockShape shape = BlockRegistry::getShape(type);
 
-                                if (type == BlockType::TORCH) {
-                                        addTorchMesh(mVertices, mChunkX, mChunkZ, x, y, z);
+                                if (shape == BlockShape::TORCH) {
+                                        addTorchMesh(mVertices, mChunkX, mChunkZ, x, y, z, packVertexLight(getBlockLight(x, y, z), getSkyLight(x, y, z)));
                                         continue;
                                 }
 
-                                if (!isFullBlock(type)) continue;
+                                if (shape != BlockShape::CUBE) continue;
 
                                 // Culling: only add faces that are exposed
-                                if (shouldRenderFace(this, x, y, z, 0, 0, 1))  addFace(mVertices, mChunkX, mChunkZ, x, y, z, glm::vec3( 0,  0,  1), type);
-                                if (shouldRenderFace(this, x, y, z, 0, 0, -1)) addFace(mVertices, mChunkX, mChunkZ, x, y, z, glm::vec3( 0,  0, -1), type);
-                                if (shouldRenderFace(this, x, y, z, 0, 1, 0))  addFace(mVertices, mChunkX, mChunkZ, x, y, z, glm::vec3( 0,  1,  0), type);
-                                if (shouldRenderFace(this, x, y, z, 0, -1, 0)) addFace(mVertices, mChunkX, mChunkZ, x, y, z, glm::vec3( 0, -1,  0), type);
-                                if (shouldRenderFace(this, x, y, z, 1, 0, 0))  addFace(mVertices, mChunkX, mChunkZ, x, y, z, glm::vec3( 1,  0,  0), type);
-                                if (shouldRenderFace(this, x, y, z, -1, 0, 0)) addFace(mVertices, mChunkX, mChunkZ, x, y, z, glm::vec3(-1,  0,  0), type);
+                                for (const auto& dir : FACE_DIRECTIONS) {
+                                        if (shouldRenderFace(this, x, y, z, dir.dx, dir.dy, dir.dz)) {
+                                                glm::vec3 normal(dir.dx, dir.dy, dir.dz);
+                                                glm::vec3 corners[4];
+                                                getFaceCorners(normal, corners);
+
+                                                int ao[4] = { MAX_AO_LEVEL, MAX_AO_LEVEL, MAX_AO_LEVEL, MAX_AO_LEVEL };
+                                                if (sAmbientOcclusion) {
+                                                        computeFaceAO(x, y, z, glm::ivec3(dir.dx, dir.dy, dir.dz), corners, ao);
+                                                }
+
+                                                // A face is lit by the voxel it looks into
+                                                int blockLight = sampleLight(LIGHT_BLOCK, x + dir.dx, y + dir.dy, z + dir.dz);
+                                                int skyLight = sampleLight(LIGHT_SKY, x + dir.dx, y + dir.dy, z + dir.dz);
+                                                addFace(mVertices, mChunkX, mChunkZ, x, y, z, normal, BlockRegistry::getFaceLayer(type, dir.face),
+                                                        corners, blockLight, skyLight, ao);
+                                        }
+                                }
                         }
                 }
         }
 
-        mVertexCount = mVertices.size();
+        Section& sec = mSections[section];
+        sec.vertexCount = (int)mVertices.size();
 
-        if (mVAO == 0) {
-                glGenVertexArrays(1, &mVAO);
-                glGenBuffers(1, &mVBO);
-        }
+        if (sec.vao == 0) {
+                glGenVertexArrays(1, &sec.vao);
+                glGenBuffers(1, &sec.vbo);
 
-        glBindVertexArray(mVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-        glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(CubeVertex), mVertices.data(), GL_STATIC_DRAW);
+                GLState::bindVertexArray(sec.vao);
+                glBindBuffer(GL_ARRAY_BUFFER, sec.vbo);
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (void*)0);
-        glEnableVertexAttribArray(0);
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (void*)0);
+                glEnableVertexAttribArray(0);
 
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (void*)offsetof(CubeVertex, normal));
-        glEnableVertexAttribArray(1);
+                glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (void*)offsetof(CubeVertex, normal));
+                glEnableVertexAttribArray(1);
 
-        // texCoords now contain (u, v, textureIndex) so we must read 3 floats
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (void*)offsetof(CubeVertex, texCoords));
-        glEnableVertexAttribArray(2);
+                // texCoords now contain (u, v, textureIndex) so we must read 3 floats
+                glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (void*)offsetof(CubeVertex, texCoords));
+                glEnableVertexAttribArray(2);
 
-        glBindVertexArray(0);
-}
+                // Packed light levels stay integers, the shader unpacks the bit fields
+                glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(CubeVertex), (void*)offsetof(CubeVertex, light));
+                glEnableVertexAttribArray(3);
 
-void Chunk::draw() {
-        if (mVertexCount == 0) return;
+                GLState::bindVertexArray(0);
+        }
 
-        glBindVertexArray(mVAO);
-        glDrawArrays(GL_TRIANGLES, 0, mVertexCount);
-        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, sec.vbo);
+        glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(CubeVertex), mVertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-BlockMaterial Chunk::getMaterialForTextureIndex(int textureIndex) {
-    // Find BlockType by reverse-lookup of the texture index
-    BlockType targetType = BlockType::AIR;
-    for (const auto& pair : m_textureConfig) {
-        BlockType type = pair.first;
-        const BlockTexturePaths& config = pair.second;
+void Chunk::updateSectionConnectivity(int section) {
+        Section& sec = mSections[section];
+        sec.connectivityDirty = false;
+        sec.connectivity = 0;
+
+        const int yBegin = section * SECTION_HEIGHT;
+        const int VOXELS = CHUNK_SIZE * SECTION_HEIGHT * CHUNK_SIZE;
+        auto voxelIndex = [](int x, int y, int z) { return (x * SECTION_HEIGHT + y) * CHUNK_SIZE + z; };
 
-        // Check all texture paths for this BlockType
-        if (!config.top.empty() && m_pathToTextureIndex.count(config.top) && m_pathToTextureIndex.at(config.top) == textureIndex) {
-            targetType = type; break;
+        // Opaque voxels start out visited, so the fill only walks open space
+        std::bitset<CHUNK_SIZE * SECTION_HEIGHT * CHUNK_SIZE> visited;
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+                for (int y = 0; y < SECTION_HEIGHT; y++) {
+                        for (int z = 0; z < CHUNK_SIZE; z++) {
+                                if (BlockRegistry::isOpaque(mBlocks[x][yBegin + y][z])) visited.set(voxelIndex(x, y, z));
+                        }
+                }
         }
-        if (!config.bottom.empty() && m_pathToTextureIndex.count(config.bottom) && m_pathToTextureIndex.at(config.bottom) == textureIndex) {
-            targetType = type; break;
+        if (visited.none()) {
+                sec.connectivity = ~0ull; // All air: every face sees every other
+                return;
         }
-        if (!config.side.empty() && m_pathToTextureIndex.count(config.side) && m_pathToTextureIndex.at(config.side) == textureIndex) {
-            targetType = type; break;
+
+        for (int start = 0; start < VOXELS; start++) {
+                if (visited.test(start)) continue;
+
+                int faces = 0; // SectionFace bits this pocket touches
+                visited.set(start);
+                mFloodStack.clear();
+                mFloodStack.push_back(start);
+                while (!mFloodStack.empty()) {
+                        int index = mFloodStack.back();
+                        mFloodStack.pop_back();
+                        int z = index % CHUNK_SIZE;
+                        int y = (index / CHUNK_SIZE) % SECTION_HEIGHT;
+                        int x = index / (CHUNK_SIZE * SECTION_HEIGHT);
+
+                        if (x == CHUNK_SIZE - 1) faces |= 1 << SECTION_POS_X;
+                        if (x == 0) faces |= 1 << SECTION_NEG_X;
+                        if (y == SECTION_HEIGHT - 1) faces |= 1 << SECTION_POS_Y;
+                        if (y == 0) faces |= 1 << SECTION_NEG_Y;
+                        if (z == CHUNK_SIZE - 1) faces |= 1 << SECTION_POS_Z;
+                        if (z == 0) faces |= 1 << SECTION_NEG_Z;
+
+                        for (const auto& dir : FACE_DIRECTIONS) {
+                                int nx = x + dir.dx, ny = y + dir.dy, nz = z + dir.dz;
+                                if (nx < 0 || nx >= CHUNK_SIZE || ny < 0 || ny >= SECTION_HEIGHT || nz < 0 || nz >= CHUNK_SIZE) continue;
+                                int next = voxelIndex(nx, ny, nz);
+                                if (visited.test(next)) continue;
+                                visited.set(next);
+                                mFloodStack.push_back(next);
+                        }
+                }
+
+                for (int from = 0; from < SECTION_FACE_COUNT; from++) {
+                        if (!(faces & (1 << from))) continue;
+                        for (int to = 0; to < SECTION_FACE_COUNT; to++) {
+                                if (faces & (1 << to)) sec.connectivity |= 1ull << (from * SECTION_FACE_COUNT + to);
+                        }
+                }
         }
-        if (!config.special.empty() && m_pathToTextureIndex.count(config.special) && m_pathToTextureIndex.at(config.special) == textureIndex) {
-            targetType = type; break;
+}
+
+void Chunk::updateOccluders() {
+        mOccludersDirty = false;
+        mOccluders.clear();
+
+        const int CELLS = CHUNK_SIZE / OCCLUDER_CELL_SIZE;
+        for (int cellZ = 0; cellZ < CELLS; cellZ++) {
+                for (int cellX = 0; cellX < CELLS; cellX++) {
+                        int x0 = cellX * OCCLUDER_CELL_SIZE, z0 = cellZ * OCCLUDER_CELL_SIZE;
+
+                        // Walk down from the lowest column top while the whole layer of the cell is opaque
+                        int top = CHUNK_HEIGHT;
+                        for (int x = x0; x < x0 + OCCLUDER_CELL_SIZE; x++) {
+                                for (int z = z0; z < z0 + OCCLUDER_CELL_SIZE; z++) {
+                                        top = std::min(top, mHeightMap[x][z]);
+                                }
+                        }
+                        int bottom = top;
+                        bool solid = true;
+                        while (bottom > 0 && solid) {
+                                for (int x = x0; x < x0 + OCCLUDER_CELL_SIZE && solid; x++) {
+                                        for (int z = z0; z < z0 + OCCLUDER_CELL_SIZE && solid; z++) {
+                                                solid = BlockRegistry::isOpaque(mBlocks[x][bottom - 1][z]);
+                                        }
+                                }
+                                if (solid) bottom--;
+                        }
+                        if (bottom == top) continue;
+
+                        // Extend the previous box of this row when it covers the same layers
+                        if (!mOccluders.empty()) {
+                                OccluderBox& last = mOccluders.back();
+                                if (last.min.z == z0 && last.max.x == x0 && last.min.y == bottom && last.max.y == top) {
+                                        last.max.x += OCCLUDER_CELL_SIZE;
+                                        continue;
+                                }
+                        }
+                        mOccluders.push_back({ glm::ivec3(x0, bottom, z0), glm::ivec3(x0 + OCCLUDER_CELL_SIZE, top, z0 + OCCLUDER_CELL_SIZE) });
+                }
         }
-    }
+}
 
-    // Return the configured material or a default one
-    if (m_materialConfig.count(targetType)) {
-        return m_materialConfig.at(targetType);
-    }
+void Chunk::draw() {
+        for (const auto& section : mSections) {
+                if (section.vertexCount == 0) continue;
 
-    // Default (matches original global material)
-    return {glm::vec3(1.0f), glm::vec3(0.1f), 8.0f};
-}
\ No newline at end of file
+                GLState::bindVertexArray(section.vao);
+                glDrawArrays(GL_TRIANGLES, 0, section.vertexCount);
+        }
+}
@@ -2,9 +2,8 @@
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <vector>
-#include <string>
-#include <map>
 
 #include "Block.h"
 
@@ -15,32 +14,132 @@ public:
 
 	static const int CHUNK_VOXEL_COUNT = CHUNK_SIZE * CHUNK_HEIGHT * CHUNK_SIZE;
 
+	// Meshes are stored per vertical 16^3 section so an edit only remeshes what it touches
+	static const int SECTION_HEIGHT = 16;
+	static const int SECTION_COUNT = CHUNK_HEIGHT / SECTION_HEIGHT;
+
+	// Horizontal neighbours, linked by World so lighting and meshing can look across borders
+	enum Side {
+		SIDE_POS_X,
+		SIDE_NEG_X,
+		SIDE_POS_Z,
+		SIDE_NEG_Z,
+		SIDE_COUNT
+	};
+
+	// Block light comes from emitters, sky light from open columns; both spread by LightPropagator
+	enum LightChannel {
+		LIGHT_BLOCK,
+		LIGHT_SKY,
+		LIGHT_CHANNEL_COUNT
+	};
+
+	// Faces of a section's box, for the connectivity used by visibility culling
+	enum SectionFace {
+		SECTION_POS_X,
+		SECTION_NEG_X,
+		SECTION_POS_Y,
+		SECTION_NEG_Y,
+		SECTION_POS_Z,
+		SECTION_NEG_Z,
+		SECTION_FACE_COUNT
+	};
+
+	// Solid box under the surface, in local block coordinates (max exclusive), for occlusion culling
+	struct OccluderBox {
+		glm::ivec3 min;
+		glm::ivec3 max;
+	};
+	// Occluders are built per column cell of this many blocks squared
+	static const int OCCLUDER_CELL_SIZE = 4;
+
+	static const int MAX_LIGHT_LEVEL = 15;
+
+	// Corner ambient occlusion, 0 = fully occluded, 3 = open
+	static const int MAX_AO_LEVEL = 3;
+
+	// Vertex light layout: bits 0-3 block light level, bits 4-7 sky light level, bits 8-9 AO level
+	static unsigned int packVertexLight(int blockLight, int skyLight, int ao = MAX_AO_LEVEL) {
+		return ((unsigned int)blockLight & 0xF) | (((unsigned int)skyLight & 0xF) << 4) | (((unsigned int)ao & 0x3) << 8);
+	}
+
+	// Meshing with or without baked AO, so the edit benchmark can measure its cost
+	static void setAmbientOcclusionEnabled(bool enabled) { sAmbientOcclusion = enabled; }
+	static bool getAmbientOcclusionEnabled() { return sAmbientOcclusion; }
+
 	Chunk(int chunkX, int chunkZ);
 	~Chunk();
 
 	void generate(long long worldSeed);
 	void buildMesh();
+	void buildSectionMesh(int section);
 	void draw();
 
 	BlockType getBlock(int x, int y, int z) const;
 	void setBlock(int x, int y, int z, BlockType type);
 
+	// Light level (0..15) of a channel, written by LightPropagator. Above the chunk is open sky.
+	int getLight(LightChannel channel, int x, int y, int z) const;
+	void setLight(LightChannel channel, int x, int y, int z, int level) { mLight[channel][x][y][z] = (unsigned char)level; }
+	int getBlockLight(int x, int y, int z) const { return getLight(LIGHT_BLOCK, x, y, z); }
+	int getSkyLight(int x, int y, int z) const { return getLight(LIGHT_SKY, x, y, z); }
+
+	// One above the topmost opaque block of the column, 0 for a column open to the bottom
+	int getHeight(int x, int z) const { return mHeightMap[x][z]; }
+
+	Chunk* getNeighbour(Side side) const { return mNeighbours[side]; }
+	void setNeighbour(Side side, Chunk* chunk) { mNeighbours[side] = chunk; }
+
 	glm::vec3 getWorldPosition() const { return glm::vec3(mChunkX * CHUNK_SIZE, 0, mChunkZ * CHUNK_SIZE); }
 
-	static std::map<BlockType, BlockTexturePaths> m_textureConfig;
-	static std::map<BlockType, BlockMaterial> m_materialConfig;
-    static std::map<std::string, int> m_pathToTextureIndex;
-    static int m_nextTextureIndex;
+	// Section meshes for the render queue, vertices are already in world space
+	GLuint getSectionVAO(int section) const { return mSections[section].vao; }
+	int getSectionVertexCount(int section) const { return mSections[section].vertexCount; }
+	glm::vec3 getSectionCenter(int section) const {
+		return getWorldPosition() + glm::vec3(CHUNK_SIZE * 0.5f, section * SECTION_HEIGHT + SECTION_HEIGHT * 0.5f, CHUNK_SIZE * 0.5f);
+	}
 
-	static BlockMaterial getMaterialForTextureIndex(int textureIndex);
+	// Whether a line of sight can enter the section through one face and leave through the other,
+	// i.e. both faces touch the same pocket of non-opaque voxels. Refreshed when the section is
+	// remeshed after a block change.
+	bool areSectionFacesConnected(int section, SectionFace from, SectionFace to) const {
+		return (mSections[section].connectivity >> (from * SECTION_FACE_COUNT + to)) & 1;
+	}
+
+	// For each column cell, the run of fully opaque layers just below its lowest surface block,
+	// with equal runs merged along x. Refreshed when a section is remeshed after a block change.
+	const std::vector<OccluderBox>& getOccluders() const { return mOccluders; }
 
 private:
 	int mChunkX, mChunkZ;
 	BlockType mBlocks[CHUNK_SIZE][CHUNK_HEIGHT][CHUNK_SIZE];
+	unsigned char mLight[LIGHT_CHANNEL_COUNT][CHUNK_SIZE][CHUNK_HEIGHT][CHUNK_SIZE];
+	int mHeightMap[CHUNK_SIZE][CHUNK_SIZE];
+	Chunk* mNeighbours[SIDE_COUNT] = {};
+
+	void updateHeight(int x, int z);
+
+	// Light of a voxel that may lie in a neighbouring chunk (x or z one step outside)
+	int sampleLight(LightChannel channel, int x, int y, int z) const;
+	// Block that may lie in a neighbouring chunk, including the diagonal ones; AIR outside the world
+	BlockType sampleBlock(int x, int y, int z) const;
+	// AO level of the four corners of a face, in addFace corner order
+	void computeFaceAO(int x, int y, int z, const glm::ivec3& normal, const glm::vec3 cornerOffsets[4], int ao[4]) const;
+	// Flood fills the section's non-opaque voxels and records which faces each pocket touches
+	void updateSectionConnectivity(int section);
+	void updateOccluders();
 
-	GLuint mVAO, mVBO;
-	std::vector<CubeVertex> mVertices;
-	int mVertexCount;
+	static bool sAmbientOcclusion;
 
-	static void initializeTextureConfig();
+	struct Section {
+		GLuint vao = 0, vbo = 0;
+		int vertexCount = 0;
+		uint64_t connectivity = ~0ull; // Bit from * SECTION_FACE_COUNT + to, symmetric
+		bool connectivityDirty = true; // Blocks changed since the last flood fill
+	};
+	Section mSections[SECTION_COUNT];
+	std::vector<CubeVertex> mVertices; // Scratch buffer reused between section builds
+	std::vector<int> mFloodStack;      // Scratch for updateSectionConnectivity
+	std::vector<OccluderBox> mOccluders;
+	bool mOccludersDirty = true;
 };
\ No newline at end of file
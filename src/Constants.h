@@ -1,18 +1,31 @@
 #pragma once
 
-constexpr int MAX_BLOCK_TEXTURES = 16;
-constexpr int MAX_POINT_LIGHTS = 32;
+// Block textures are layers of one GL_TEXTURE_2D_ARRAY; GL 3.3 guarantees at least 256 layers
+constexpr int MAX_BLOCK_TEXTURES = 256;
+constexpr int BLOCK_TEXTURE_SIZE = 256;
+// Point lights are clustered and streamed through buffer textures, so this is a sanity cap, not a UBO size
+constexpr int MAX_POINT_LIGHTS = 1024;
 constexpr int MAX_SPOT_LIGHTS = 8;
+// Emissive blocks turned into point lights in dynamic block light mode, nearest and brightest first
+constexpr int MAX_SELECTED_EMITTERS = 64;
 
+// Sun shadow cascades (2 to 4), each a DIR_SHADOW_WIDTH^2 layer fitted to a slice of the view frustum
+constexpr int DIR_SHADOW_CASCADES = 3;
 constexpr unsigned int DIR_SHADOW_WIDTH = 2048;
 constexpr unsigned int DIR_SHADOW_HEIGHT = 2048;
 
-constexpr unsigned int POINT_SHADOW_WIDTH = 1024;
-constexpr unsigned int POINT_SHADOW_HEIGHT = 1024;
+// Point and spot shadows share one depth atlas: a fixed texel budget whatever the light count
+constexpr int SHADOW_ATLAS_SIZE = 4096;
+
 constexpr float POINT_NEAR_PLANE = 0.1f;
 constexpr float POINT_FAR_PLANE = 20.0f;
+// Point lights that get shadows, most relevant first; each one's six faces are drawn in one pass
+constexpr int MAX_POINT_SHADOWS = 4;
 
-constexpr unsigned int SPOT_SHADOW_WIDTH = 1024;
-constexpr unsigned int SPOT_SHADOW_HEIGHT = 1024;
 constexpr float SPOT_NEAR_PLANE = 0.1f;
-constexpr float SPOT_FAR_PLANE = 30.0f;
\ No newline at end of file
+constexpr float SPOT_FAR_PLANE = 30.0f;
+
+// Uniform block binding points, shared by every program that declares the block
+constexpr unsigned int BLOCK_MATERIALS_BINDING = 0;
+constexpr unsigned int FRAME_DATA_BINDING = 1;
+constexpr unsigned int LIGHTS_BINDING = 2;
@@ -1,4 +1,6 @@
 #include "Cube.h"
+#include "Chunk.h"
+#include "GLState.h"
 #include <iostream>
 
 std::vector<CubeVertex> Cube::vertices;
@@ -12,7 +14,7 @@ Cube::Cube() : mVAO(0), mVBO(0), mEBO(0) {
 }
 
 Cube::~Cube() {
-        glDeleteVertexArrays(1, &mVAO);
+        GLState::deleteVertexArrays(1, &mVAO);
         glDeleteBuffers(1, &mVBO);
         glDeleteBuffers(1, &mEBO);
 }
@@ -55,6 +57,11 @@ void Cube::initializeMeshData() {
         vertices.push_back({{-0.5f,  0.5f,  0.5f}, {-1.0f,  0.0f,  0.0f}, {1.0f, 1.0f, 0.0f}});
         vertices.push_back({{-0.5f,  0.5f, -0.5f}, {-1.0f,  0.0f,  0.0f}, {0.0f, 1.0f, 0.0f}});
 
+        // Same baked light as models: no block light, full sky light
+        for (auto& vertex : vertices) {
+                vertex.light = Chunk::packVertexLight(0, Chunk::MAX_LIGHT_LEVEL);
+        }
+
         // Define indices for triangles (2 triangles per face)
         for (int i = 0; i < 6; i++) {
                 int offset = i * 4;
@@ -78,7 +85,7 @@ void Cube::setupMesh() {
         glGenBuffers(1, &mVBO);
         glGenBuffers(1, &mEBO);
 
-        glBindVertexArray(mVAO);
+        GLState::bindVertexArray(mVAO);
 
         glBindBuffer(GL_ARRAY_BUFFER, mVBO);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(CubeVertex), vertices.data(), GL_STATIC_DRAW);
@@ -98,13 +105,16 @@ void Cube::setupMesh() {
         glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (void*)offsetof(CubeVertex, texCoords));
         glEnableVertexAttribArray(2);
 
-        glBindVertexArray(0);
+        // Packed light, an integer attribute like the chunk meshes'
+        glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(CubeVertex), (void*)offsetof(CubeVertex, light));
+        glEnableVertexAttribArray(3);
+
+        GLState::bindVertexArray(0);
 }
 
 void Cube::draw() {
-        glBindVertexArray(mVAO);
+        GLState::bindVertexArray(mVAO);
         glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
 }
 
 const std::vector<CubeVertex>& Cube::getVertices() {
@@ -1,22 +1,26 @@
 #include "DebugDrawer.h"
+#include "GLState.h"
+#include "Constants.h"
 #include <glm/gtc/matrix_transform.hpp>
 
 DebugDrawer::DebugDrawer() {}
 
 DebugDrawer::~DebugDrawer() {
-    if (m_lineVAO) glDeleteVertexArrays(1, &m_lineVAO);
+    if (m_lineVAO) GLState::deleteVertexArrays(1, &m_lineVAO);
     if (m_lineVBO) glDeleteBuffers(1, &m_lineVBO);
-    if (m_pointVAO) glDeleteVertexArrays(1, &m_pointVAO);
+    if (m_pointVAO) GLState::deleteVertexArrays(1, &m_pointVAO);
     if (m_pointVBO) glDeleteBuffers(1, &m_pointVBO);
 }
 
 void DebugDrawer::init() {
     m_shader = std::make_unique<ShaderProgram>();
     m_shader->loadShaders("./debug_line.vert", "./debug_line.frag");
+    // View and projection come from the renderer's per-frame uniform buffer
+    m_shader->bindUniformBlock("FrameData", FRAME_DATA_BINDING);
 
     glGenVertexArrays(1, &m_lineVAO);
     glGenBuffers(1, &m_lineVBO);
-    glBindVertexArray(m_lineVAO);
+    GLState::bindVertexArray(m_lineVAO);
     glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6, nullptr, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -24,16 +28,16 @@ void DebugDrawer::init() {
 
     glGenVertexArrays(1, &m_pointVAO);
     glGenBuffers(1, &m_pointVBO);
-    glBindVertexArray(m_pointVAO);
+    GLState::bindVertexArray(m_pointVAO);
     glBindBuffer(GL_ARRAY_BUFFER, m_pointVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3, nullptr, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
-void DebugDrawer::drawRaycast(const FPSCamera& camera, const RaycastHit& hit, int windowWidth, int windowHeight) {
+void DebugDrawer::drawRaycast(const FPSCamera& camera, const RaycastHit& hit) {
     glm::vec3 origin = camera.getPosition();
     glm::vec3 dir = glm::normalize(camera.getLook());
 
@@ -51,16 +55,12 @@ void DebugDrawer::drawRaycast(const FPSCamera& camera, const RaycastHit& hit, in
 
     m_shader->use();
     m_shader->setUniform("model", glm::mat4(1.0f));
-    m_shader->setUniform("view", camera.getViewMatrix());
-    float aspectRatio = (float)windowWidth / (float)windowHeight;
-    glm::mat4 projection = glm::perspective(glm::radians(camera.getFOV()), aspectRatio, 0.1f, 200.0f);
-    m_shader->setUniform("projection", projection);
 
-    glDisable(GL_DEPTH_TEST);
+    GLState::disable(GL_DEPTH_TEST);
 
     // Line (red)
     m_shader->setUniform("uColor", glm::vec3(1.0f, 0.0f, 0.0f));
-    glBindVertexArray(m_lineVAO);
+    GLState::bindVertexArray(m_lineVAO);
     glLineWidth(4.0f);
     glDrawArrays(GL_LINES, 0, 2);
 
@@ -70,7 +70,7 @@ void DebugDrawer::drawRaycast(const FPSCamera& camera, const RaycastHit& hit, in
         glBindBuffer(GL_ARRAY_BUFFER, m_pointVBO);
         glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(hitPt), hitPt);
         m_shader->setUniform("uColor", glm::vec3(0.0f, 1.0f, 0.0f));
-        glBindVertexArray(m_pointVAO);
+        GLState::bindVertexArray(m_pointVAO);
         glPointSize(12.0f);
         glDrawArrays(GL_POINTS, 0, 1);
 
@@ -83,6 +83,5 @@ void DebugDrawer::drawRaycast(const FPSCamera& camera, const RaycastHit& hit, in
         glDrawArrays(GL_POINTS, 0, 1);
     }
 
-    glBindVertexArray(0);
-    glEnable(GL_DEPTH_TEST);
+    GLState::enable(GL_DEPTH_TEST);
 }
\ No newline at end of file
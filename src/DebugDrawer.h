@@ -12,7 +12,7 @@ public:
     ~DebugDrawer();
 
     void init();
-    void drawRaycast(const FPSCamera& camera, const RaycastHit& hit, int windowWidth, int windowHeight);
+    void drawRaycast(const FPSCamera& camera, const RaycastHit& hit);
 
 private:
     std::unique_ptr<ShaderProgram> m_shader;
@@ -0,0 +1,228 @@
+#include "GLState.h"
+
+namespace {
+        // Never a valid GL name, so the first call after invalidate() is always issued
+        const GLuint UNKNOWN = 0xFFFFFFFFu;
+}
+
+GLuint GLState::sProgram = UNKNOWN;
+GLuint GLState::sVertexArray = UNKNOWN;
+GLuint GLState::sReadFramebuffer = UNKNOWN;
+GLuint GLState::sDrawFramebuffer = UNKNOWN;
+GLuint GLState::sActiveUnit = UNKNOWN;
+GLuint GLState::sTextures[MAX_UNITS][TARGET_COUNT];
+int GLState::sCaps[CAP_COUNT] = { -1, -1, -1, -1 };
+GLenum GLState::sBlendSrc = UNKNOWN;
+GLenum GLState::sBlendDst = UNKNOWN;
+GLenum GLState::sCullFace = UNKNOWN;
+GLint GLState::sViewport[4] = { -1, -1, -1, -1 };
+int GLState::sColorMask = -1;
+GLenum GLState::sDepthFunc = UNKNOWN;
+int GLState::sDepthMask = -1;
+GLState::Stats GLState::sFrame;
+GLState::Stats GLState::sLastFrame;
+
+int GLState::targetIndex(GLenum target) {
+        switch (target) {
+                case GL_TEXTURE_2D: return 0;
+                case GL_TEXTURE_2D_ARRAY: return 1;
+                case GL_TEXTURE_CUBE_MAP: return 2;
+                case GL_TEXTURE_BUFFER: return 3;
+                default: return -1;
+        }
+}
+
+int GLState::capIndex(GLenum cap) {
+        switch (cap) {
+                case GL_DEPTH_TEST: return 0;
+                case GL_CULL_FACE: return 1;
+                case GL_BLEND: return 2;
+                case GL_POLYGON_OFFSET_FILL: return 3;
+                default: return -1;
+        }
+}
+
+bool GLState::skip(bool unchanged) {
+        if (unchanged) {
+                sFrame.skipped++;
+        } else {
+                sFrame.issued++;
+        }
+        return unchanged;
+}
+
+void GLState::useProgram(GLuint program) {
+        if (skip(sProgram == program)) return;
+        sProgram = program;
+        glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+        if (skip(sVertexArray == vao)) return;
+        sVertexArray = vao;
+        glBindVertexArray(vao);
+}
+
+void GLState::bindFramebuffer(GLuint fbo) {
+        if (skip(sReadFramebuffer == fbo && sDrawFramebuffer == fbo)) return;
+        sReadFramebuffer = fbo;
+        sDrawFramebuffer = fbo;
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+}
+
+void GLState::bindReadFramebuffer(GLuint fbo) {
+        if (skip(sReadFramebuffer == fbo)) return;
+        sReadFramebuffer = fbo;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+}
+
+void GLState::bindDrawFramebuffer(GLuint fbo) {
+        if (skip(sDrawFramebuffer == fbo)) return;
+        sDrawFramebuffer = fbo;
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+}
+
+void GLState::activeTexture(GLuint unit) {
+        if (skip(sActiveUnit == unit)) return;
+        sActiveUnit = unit;
+        glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+        int index = targetIndex(target);
+        if (unit < (GLuint)MAX_UNITS && index >= 0 && skip(sTextures[unit][index] == texture)) return;
+
+        activeTexture(unit);
+        glBindTexture(target, texture);
+        if (unit < (GLuint)MAX_UNITS && index >= 0) {
+                sTextures[unit][index] = texture;
+        } else {
+                sFrame.issued++;
+        }
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture) {
+        if (sActiveUnit == UNKNOWN) {
+                activeTexture(0);
+        }
+        bindTexture(sActiveUnit, target, texture);
+}
+
+void GLState::enable(GLenum cap) {
+        int index = capIndex(cap);
+        if (index >= 0) {
+                if (skip(sCaps[index] == 1)) return;
+                sCaps[index] = 1;
+        } else {
+                sFrame.issued++;
+        }
+        glEnable(cap);
+}
+
+void GLState::disable(GLenum cap) {
+        int index = capIndex(cap);
+        if (index >= 0) {
+                if (skip(sCaps[index] == 0)) return;
+                sCaps[index] = 0;
+        } else {
+                sFrame.issued++;
+        }
+        glDisable(cap);
+}
+
+void GLState::blendFunc(GLenum src, GLenum dst) {
+        if (skip(sBlendSrc == src && sBlendDst == dst)) return;
+        sBlendSrc = src;
+        sBlendDst = dst;
+        glBlendFunc(src, dst);
+}
+
+void GLState::cullFace(GLenum mode) {
+        if (skip(sCullFace == mode)) return;
+        sCullFace = mode;
+        glCullFace(mode);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (skip(sViewport[0] == x && sViewport[1] == y && sViewport[2] == width && sViewport[3] == height)) return;
+        sViewport[0] = x;
+        sViewport[1] = y;
+        sViewport[2] = width;
+        sViewport[3] = height;
+        glViewport(x, y, width, height);
+}
+
+void GLState::colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
+        int mask = (red ? 1 : 0) | (green ? 2 : 0) | (blue ? 4 : 0) | (alpha ? 8 : 0);
+        if (skip(sColorMask == mask)) return;
+        sColorMask = mask;
+        glColorMask(red, green, blue, alpha);
+}
+
+void GLState::depthFunc(GLenum func) {
+        if (skip(sDepthFunc == func)) return;
+        sDepthFunc = func;
+        glDepthFunc(func);
+}
+
+void GLState::depthMask(GLboolean flag) {
+        int mask = flag ? 1 : 0;
+        if (skip(sDepthMask == mask)) return;
+        sDepthMask = mask;
+        glDepthMask(flag);
+}
+
+void GLState::deleteProgram(GLuint program) {
+        if (sProgram == program) sProgram = 0;
+        glDeleteProgram(program);
+}
+
+void GLState::deleteVertexArrays(GLsizei count, const GLuint* vaos) {
+        for (GLsizei i = 0; i < count; i++) {
+                if (sVertexArray == vaos[i]) sVertexArray = 0;
+        }
+        glDeleteVertexArrays(count, vaos);
+}
+
+void GLState::deleteFramebuffers(GLsizei count, const GLuint* fbos) {
+        for (GLsizei i = 0; i < count; i++) {
+                if (sReadFramebuffer == fbos[i]) sReadFramebuffer = 0;
+                if (sDrawFramebuffer == fbos[i]) sDrawFramebuffer = 0;
+        }
+        glDeleteFramebuffers(count, fbos);
+}
+
+void GLState::deleteTextures(GLsizei count, const GLuint* textures) {
+        // Deleting a bound texture reverts that binding to 0
+        for (GLsizei i = 0; i < count; i++) {
+                for (auto& unit : sTextures) {
+                        for (GLuint& bound : unit) {
+                                if (bound == textures[i]) bound = 0;
+                        }
+                }
+        }
+        glDeleteTextures(count, textures);
+}
+
+void GLState::invalidate() {
+        sProgram = UNKNOWN;
+        sVertexArray = UNKNOWN;
+        sReadFramebuffer = UNKNOWN;
+        sDrawFramebuffer = UNKNOWN;
+        sActiveUnit = UNKNOWN;
+        for (auto& unit : sTextures) {
+                for (GLuint& bound : unit) bound = UNKNOWN;
+        }
+        for (int& cap : sCaps) cap = -1;
+        sBlendSrc = sBlendDst = UNKNOWN;
+        sCullFace = UNKNOWN;
+        for (GLint& v : sViewport) v = -1;
+        sColorMask = -1;
+        sDepthFunc = UNKNOWN;
+        sDepthMask = -1;
+}
+
+void GLState::beginFrame() {
+        sLastFrame = sFrame;
+        sFrame = Stats();
+}
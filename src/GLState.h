@@ -0,0 +1,79 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#ifndef GLEW_STATIC
+#define GLEW_STATIC
+#endif
+#include "GL/glew.h"
+
+// Shadow copy of the GL bindings and capabilities the renderer touches. Every change goes
+// through here so calls that would not change anything are skipped (and counted).
+// Objects must be deleted through the delete* helpers, otherwise a recycled name could be
+// mistaken for one that is still bound.
+class GLState {
+    public:
+        struct Stats {
+                int issued = 0;
+                int skipped = 0;
+        };
+
+        static void useProgram(GLuint program);
+        static void bindVertexArray(GLuint vao);
+        static void bindFramebuffer(GLuint fbo); // Both targets
+        static void bindReadFramebuffer(GLuint fbo);
+        static void bindDrawFramebuffer(GLuint fbo);
+
+        // Binds on a given unit; the two-argument form uses whichever unit is active (uploads)
+        static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+        static void bindTexture(GLenum target, GLuint texture);
+        static void activeTexture(GLuint unit);
+
+        static void enable(GLenum cap);
+        static void disable(GLenum cap);
+        static void blendFunc(GLenum src, GLenum dst);
+        static void cullFace(GLenum mode);
+        static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+        static void colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+        static void depthFunc(GLenum func);
+        static void depthMask(GLboolean flag);
+
+        static void deleteProgram(GLuint program);
+        static void deleteVertexArrays(GLsizei count, const GLuint* vaos);
+        static void deleteFramebuffers(GLsizei count, const GLuint* fbos);
+        static void deleteTextures(GLsizei count, const GLuint* textures);
+
+        // Forgets everything, e.g. after code outside this layer touched the state
+        static void invalidate();
+
+        // Call once per frame; the previous frame's counts stay readable until the next call
+        static void beginFrame();
+        static const Stats& getLastFrameStats() { return sLastFrame; }
+
+    private:
+        static const int MAX_UNITS = 32;
+        static const int TARGET_COUNT = 4; // 2D, 2D array, cube map, buffer
+        static const int CAP_COUNT = 4;    // depth test, cull face, blend, polygon offset fill
+
+        static int targetIndex(GLenum target);
+        static int capIndex(GLenum cap);
+        static bool skip(bool unchanged);
+
+        static GLuint sProgram;
+        static GLuint sVertexArray;
+        static GLuint sReadFramebuffer;
+        static GLuint sDrawFramebuffer;
+        static GLuint sActiveUnit;
+        static GLuint sTextures[MAX_UNITS][TARGET_COUNT];
+        static int sCaps[CAP_COUNT]; // -1 unknown, 0 off, 1 on
+        static GLenum sBlendSrc, sBlendDst;
+        static GLenum sCullFace;
+        static GLint sViewport[4];
+        static int sColorMask; // -1 unknown, else one bit per channel (RGBA)
+        static GLenum sDepthFunc;
+        static int sDepthMask; // -1 unknown, 0 off, 1 on
+
+        static Stats sFrame;
+        static Stats sLastFrame;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include "LightAggregator.h"
+#include <cmath>
+
+void LightAggregator::aggregate(const std::vector<PointLight>& lights, const glm::vec3& eye, std::vector<PointLight>& out) {
+    out.clear();
+    mGroups.clear();
+
+    for (const PointLight& light : lights) {
+        float distance = glm::length(light.position - eye);
+        float cellSize = distance * CELL_SIZE_PER_DISTANCE;
+        if (cellSize < MIN_CELL_SIZE) {
+            out.push_back(light);
+            continue;
+        }
+
+        // Power-of-two bands keep the cell size stable while the eye moves a little
+        int band = (int)std::floor(std::log2(cellSize / MIN_CELL_SIZE));
+        float bandCellSize = MIN_CELL_SIZE * std::exp2((float)band);
+        glm::ivec3 cell = glm::ivec3(glm::floor(light.position / bandCellSize));
+        auto key = std::make_tuple(band, cell.x, cell.y, cell.z);
+
+        float weight = glm::max(glm::max(light.diffuse.r, light.diffuse.g), light.diffuse.b) + 1e-4f;
+
+        auto it = mGroups.find(key);
+        if (it == mGroups.end()) {
+            mGroups.emplace(key, Group{ (int)out.size(), weight, light.position * weight });
+            out.push_back(light);
+            continue;
+        }
+
+        // Colours add up; position and attenuation follow the brighter members
+        Group& group = it->second;
+        PointLight& merged = out[group.outputIndex];
+        float total = group.weight + weight;
+        merged.constant = (merged.constant * group.weight + light.constant * weight) / total;
+        merged.linear = (merged.linear * group.weight + light.linear * weight) / total;
+        merged.exponant = (merged.exponant * group.weight + light.exponant * weight) / total;
+        merged.ambient += light.ambient;
+        merged.diffuse += light.diffuse;
+        merged.specular += light.specular;
+
+        group.weight = total;
+        group.weightedPosition += light.position * weight;
+        merged.position = group.weightedPosition / group.weight;
+    }
+
+    mInputCount = (int)lights.size();
+    mOutputCount = (int)out.size();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <map>
+#include <tuple>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Light.h"
+
+// Merges point lights that are close together relative to their distance from the eye into one
+// representative light: summed colour at the intensity-weighted centroid. The merge cell grows
+// with distance, so lights near the eye are never touched and far clusters collapse to one.
+class LightAggregator {
+public:
+    // Cells stay below this size (in blocks) inside which nothing is merged
+    static constexpr float MIN_CELL_SIZE = 1.0f;
+    // Merge cell size per block of distance from the eye, i.e. the angle a cell may subtend
+    static constexpr float CELL_SIZE_PER_DISTANCE = 0.125f;
+
+    // Keeps the input order of the first light of each group, so lights[0] stays first
+    void aggregate(const std::vector<PointLight>& lights, const glm::vec3& eye, std::vector<PointLight>& out);
+
+    int getInputCount() const { return mInputCount; }
+    int getOutputCount() const { return mOutputCount; }
+
+private:
+    struct Group {
+        int outputIndex;
+        float weight;
+        glm::vec3 weightedPosition;
+    };
+
+    // (distance band, cell x, cell y, cell z)
+    std::map<std::tuple<int, int, int, int>, Group> mGroups;
+    int mInputCount = 0;
+    int mOutputCount = 0;
+};
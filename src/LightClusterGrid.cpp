@@ -0,0 +1,108 @@
+#include "LightClusterGrid.h"
+#include <cmath>
+
+namespace {
+    // Contribution below 1/256 of full intensity is invisible in an 8-bit framebuffer
+    const float LIGHT_CUTOFF = 1.0f / 256.0f;
+}
+
+float LightClusterGrid::computeRange(const PointLight& light) {
+    float intensity = glm::max(glm::max(light.diffuse.r, light.diffuse.g), light.diffuse.b);
+    intensity = glm::max(intensity, glm::max(glm::max(light.specular.r, light.specular.g), light.specular.b));
+    if (intensity <= 0.0f) return 0.0f;
+
+    // Solve intensity / (c + l*d + q*d^2) = cutoff for d
+    float c = light.constant - intensity / LIGHT_CUTOFF;
+    if (light.exponant > 0.0f) {
+        return (-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.exponant * c)) / (2.0f * light.exponant);
+    }
+    if (light.linear > 0.0f) {
+        return -c / light.linear;
+    }
+    return 1000.0f; // No falloff
+}
+
+void LightClusterGrid::build(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection,
+                             float nearPlane, float farPlane, int screenWidth, int screenHeight) {
+    // Exponential depth slices: slice = log(z) * scale - bias
+    float logRatio = std::log(farPlane / nearPlane);
+    float sliceScale = CLUSTERS_Z / logRatio;
+    float sliceBias = CLUSTERS_Z * std::log(nearPlane) / logRatio;
+    glm::vec2 tileSize = glm::vec2((float)screenWidth / CLUSTERS_X, (float)screenHeight / CLUSTERS_Y);
+    mClusterParams = glm::vec4(tileSize.x, tileSize.y, sliceScale, sliceBias);
+
+    auto sliceOf = [&](float depth) {
+        return glm::clamp((int)std::floor(std::log(glm::max(depth, nearPlane)) * sliceScale - sliceBias), 0, CLUSTERS_Z - 1);
+    };
+
+    mLightData.resize(lights.size() * TEXELS_PER_LIGHT);
+    mBounds.resize(lights.size());
+    mClusterRanges.assign(CLUSTER_COUNT * 2, 0);
+
+    // Pass 1: cluster bounds of every light, counted per cluster
+    for (size_t i = 0; i < lights.size(); i++) {
+        const PointLight& light = lights[i];
+        float range = computeRange(light);
+
+        mLightData[i * TEXELS_PER_LIGHT + 0] = glm::vec4(light.position, range);
+        mLightData[i * TEXELS_PER_LIGHT + 1] = glm::vec4(light.diffuse, light.constant);
+        mLightData[i * TEXELS_PER_LIGHT + 2] = glm::vec4(light.specular, light.linear);
+        mLightData[i * TEXELS_PER_LIGHT + 3] = glm::vec4(light.ambient, light.exponant);
+
+        ClusterBounds& bounds = mBounds[i];
+        bounds.min = glm::ivec3(0);
+        bounds.max = glm::ivec3(-1); // Empty
+
+        glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        float nearDepth = -center.z - range;
+        float farDepth = -center.z + range;
+        if (range <= 0.0f || farDepth < nearPlane || nearDepth > farPlane) continue;
+
+        glm::ivec2 tileMin(0), tileMax(CLUSTERS_X - 1, CLUSTERS_Y - 1);
+        if (nearDepth > nearPlane) {
+            // Whole sphere in front of the camera: project its view-space box to find the tiles
+            glm::vec2 ndcMin(1.0f), ndcMax(-1.0f);
+            for (int corner = 0; corner < 8; corner++) {
+                glm::vec3 offset((corner & 1) ? range : -range, (corner & 2) ? range : -range, (corner & 4) ? range : -range);
+                glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+                glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+            if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) continue;
+
+            glm::vec2 clusters((float)CLUSTERS_X, (float)CLUSTERS_Y);
+            tileMin = glm::ivec2(glm::floor((glm::clamp(ndcMin, -1.0f, 1.0f) * 0.5f + 0.5f) * clusters));
+            tileMax = glm::ivec2(glm::floor((glm::clamp(ndcMax, -1.0f, 1.0f) * 0.5f + 0.5f) * clusters));
+            tileMax = glm::min(tileMax, glm::ivec2(CLUSTERS_X - 1, CLUSTERS_Y - 1));
+        }
+
+        bounds.min = glm::ivec3(tileMin, sliceOf(nearDepth));
+        bounds.max = glm::ivec3(tileMax, sliceOf(farDepth));
+
+        for (int z = bounds.min.z; z <= bounds.max.z; z++)
+            for (int y = bounds.min.y; y <= bounds.max.y; y++)
+                for (int x = bounds.min.x; x <= bounds.max.x; x++)
+                    mClusterRanges[(x + CLUSTERS_X * (y + CLUSTERS_Y * z)) * 2 + 1]++;
+    }
+
+    // Prefix sum turns counts into offsets
+    uint32_t total = 0;
+    for (int cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+        mClusterRanges[cluster * 2] = total;
+        total += mClusterRanges[cluster * 2 + 1];
+        mClusterRanges[cluster * 2 + 1] = 0;
+    }
+
+    // Pass 2: scatter light indices
+    mLightIndices.resize(total);
+    for (size_t i = 0; i < lights.size(); i++) {
+        const ClusterBounds& bounds = mBounds[i];
+        for (int z = bounds.min.z; z <= bounds.max.z; z++)
+            for (int y = bounds.min.y; y <= bounds.max.y; y++)
+                for (int x = bounds.min.x; x <= bounds.max.x; x++) {
+                    uint32_t* range = &mClusterRanges[(x + CLUSTERS_X * (y + CLUSTERS_Y * z)) * 2];
+                    mLightIndices[range[0] + range[1]++] = (uint32_t)i;
+                }
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Light.h"
+
+// View-space froxel grid for clustered forward shading. Built on the CPU each frame: every
+// cluster gets the list of point lights whose range sphere overlaps it, so a fragment only
+// evaluates the lights of its own cluster instead of all of them.
+class LightClusterGrid {
+public:
+    static const int CLUSTERS_X = 16;
+    static const int CLUSTERS_Y = 9;
+    static const int CLUSTERS_Z = 24;
+    static const int CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+    // Texels per light in getLightData(): (position, range), (diffuse, constant), (specular, linear), (ambient, exponant)
+    static const int TEXELS_PER_LIGHT = 4;
+
+    void build(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection,
+               float nearPlane, float farPlane, int screenWidth, int screenHeight);
+
+    // Distance at which the light's contribution drops below a visible threshold
+    static float computeRange(const PointLight& light);
+
+    const std::vector<glm::vec4>& getLightData() const { return mLightData; }
+    // Two uints per cluster: offset into getLightIndices() and count
+    const std::vector<uint32_t>& getClusterRanges() const { return mClusterRanges; }
+    const std::vector<uint32_t>& getLightIndices() const { return mLightIndices; }
+
+    // Uploaded with the lights: tile size in pixels and the log-depth slice scale/bias
+    glm::vec4 getClusterParams() const { return mClusterParams; }
+
+private:
+    struct ClusterBounds {
+        glm::ivec3 min;
+        glm::ivec3 max;
+    };
+
+    std::vector<glm::vec4> mLightData;
+    std::vector<uint32_t> mClusterRanges;
+    std::vector<uint32_t> mLightIndices;
+    std::vector<ClusterBounds> mBounds; // Scratch, one per light
+    glm::vec4 mClusterParams = glm::vec4(0.0f);
+};
@@ -0,0 +1,136 @@
+#include "LightIndex.h"
+#include "Chunk.h"
+#include "BlockRegistry.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+        float score(int emission, float distanceSq) {
+                // Closer than a block away counts as touching the light
+                return (float)emission / std::max(distanceSq, 1.0f);
+        }
+
+        int floorDiv(int value, int divisor) {
+                return (value >= 0) ? value / divisor : (value + 1) / divisor - 1;
+        }
+}
+
+std::pair<int, int> LightIndex::bucketKey(const glm::ivec3& block) {
+        return { floorDiv(block.x, Chunk::CHUNK_SIZE), floorDiv(block.z, Chunk::CHUNK_SIZE) };
+}
+
+void LightIndex::updateMaxEmission(Bucket& bucket) {
+        bucket.maxEmission = 0;
+        for (const Emitter& emitter : bucket.emitters) {
+                bucket.maxEmission = std::max(bucket.maxEmission, emitter.emission);
+        }
+}
+
+void LightIndex::build(const std::vector<Chunk*>& chunks) {
+        mBuckets.clear();
+        mEmitterCount = 0;
+
+        for (const Chunk* chunk : chunks) {
+                glm::ivec3 origin = glm::ivec3(chunk->getWorldPosition());
+
+                for (int x = 0; x < Chunk::CHUNK_SIZE; x++) {
+                        for (int y = 0; y < Chunk::CHUNK_HEIGHT; y++) {
+                                for (int z = 0; z < Chunk::CHUNK_SIZE; z++) {
+                                        BlockType type = chunk->getBlock(x, y, z);
+                                        if (BlockRegistry::getEmission(type) > 0) {
+                                                setBlock(origin + glm::ivec3(x, y, z), type);
+                                        }
+                                }
+                        }
+                }
+        }
+}
+
+void LightIndex::setBlock(const glm::ivec3& block, BlockType type) {
+        std::pair<int, int> key = bucketKey(block);
+        int emission = BlockRegistry::getEmission(type);
+
+        auto it = mBuckets.find(key);
+        if (it == mBuckets.end()) {
+                if (emission == 0) return;
+                it = mBuckets.emplace(key, Bucket()).first;
+        }
+
+        Bucket& bucket = it->second;
+        auto existing = std::find_if(bucket.emitters.begin(), bucket.emitters.end(),
+                                     [&](const Emitter& emitter) { return emitter.block == block; });
+
+        if (existing != bucket.emitters.end()) {
+                if (emission > 0) {
+                        *existing = { block, type, emission };
+                } else {
+                        *existing = bucket.emitters.back();
+                        bucket.emitters.pop_back();
+                        mEmitterCount--;
+                }
+        } else if (emission > 0) {
+                bucket.emitters.push_back({ block, type, emission });
+                mEmitterCount++;
+        }
+
+        if (bucket.emitters.empty()) {
+                mBuckets.erase(it);
+        } else {
+                updateMaxEmission(bucket);
+        }
+}
+
+void LightIndex::query(const glm::vec3& eye, int maxEmitters, std::vector<Emitter>& out, QueryStats& stats) const {
+        out.clear();
+        stats = QueryStats();
+        stats.indexed = mEmitterCount;
+        if (maxEmitters <= 0 || mBuckets.empty()) return;
+
+        // Best score any emitter of a bucket could reach: its brightest emitter at the bucket's nearest point
+        struct BucketBound {
+                float bestScore;
+                const Bucket* bucket;
+        };
+        std::vector<BucketBound> bounds;
+        bounds.reserve(mBuckets.size());
+        for (const auto& entry : mBuckets) {
+                glm::vec2 minCorner = glm::vec2(entry.first.first, entry.first.second) * (float)Chunk::CHUNK_SIZE - 0.5f;
+                glm::vec2 maxCorner = minCorner + (float)Chunk::CHUNK_SIZE;
+                glm::vec2 eyeXZ(eye.x, eye.z);
+                glm::vec2 delta = eyeXZ - glm::clamp(eyeXZ, minCorner, maxCorner);
+                bounds.push_back({ score(entry.second.maxEmission, glm::dot(delta, delta)), &entry.second });
+        }
+        std::sort(bounds.begin(), bounds.end(), [](const BucketBound& a, const BucketBound& b) { return a.bestScore > b.bestScore; });
+
+        // Min-heap on score holds the current selection, so the weakest is evicted first
+        using Scored = std::pair<float, const Emitter*>;
+        auto weaker = [](const Scored& a, const Scored& b) { return a.first > b.first; };
+        std::vector<Scored> heap;
+        heap.reserve(maxEmitters + 1);
+
+        for (const BucketBound& bound : bounds) {
+                if ((int)heap.size() == maxEmitters && bound.bestScore <= heap.front().first) break;
+                stats.bucketsVisited++;
+
+                for (const Emitter& emitter : bound.bucket->emitters) {
+                        stats.candidates++;
+                        glm::vec3 delta = glm::vec3(emitter.block) - eye;
+                        float emitterScore = score(emitter.emission, glm::dot(delta, delta));
+
+                        if ((int)heap.size() < maxEmitters) {
+                                heap.push_back({ emitterScore, &emitter });
+                                std::push_heap(heap.begin(), heap.end(), weaker);
+                        } else if (emitterScore > heap.front().first) {
+                                std::pop_heap(heap.begin(), heap.end(), weaker);
+                                heap.back() = { emitterScore, &emitter };
+                                std::push_heap(heap.begin(), heap.end(), weaker);
+                        }
+                }
+        }
+
+        std::sort_heap(heap.begin(), heap.end(), weaker);
+        for (const Scored& scored : heap) {
+                out.push_back(*scored.second);
+        }
+        stats.selected = (int)out.size();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <map>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Block.h"
+
+class Chunk;
+
+// Emissive blocks bucketed by chunk, so the lights around a point can be found without
+// scanning every voxel. Kept in sync by World on generation and on every edit.
+class LightIndex {
+public:
+        struct Emitter {
+                glm::ivec3 block; // World block coordinates
+                BlockType type;
+                int emission;
+        };
+
+        struct QueryStats {
+                int indexed = 0;       // Emitters in the index
+                int bucketsVisited = 0;
+                int candidates = 0;    // Emitters scored
+                int selected = 0;
+        };
+
+        void build(const std::vector<Chunk*>& chunks);
+
+        // Records the new type of a block; only emitters are stored
+        void setBlock(const glm::ivec3& block, BlockType type);
+
+        // Up to maxEmitters emitters ranked by emission / squared distance to eye, most relevant first.
+        // Buckets are visited nearest first and skipped once they cannot beat the current selection.
+        void query(const glm::vec3& eye, int maxEmitters, std::vector<Emitter>& out, QueryStats& stats) const;
+
+        int getEmitterCount() const { return mEmitterCount; }
+
+private:
+        struct Bucket {
+                std::vector<Emitter> emitters;
+                int maxEmission = 0;
+        };
+
+        static std::pair<int, int> bucketKey(const glm::ivec3& block);
+        static void updateMaxEmission(Bucket& bucket);
+
+        std::map<std::pair<int, int>, Bucket> mBuckets;
+        int mEmitterCount = 0;
+};
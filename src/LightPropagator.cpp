@@ -0,0 +1,194 @@
+#include "LightPropagator.h"
+#include "BlockRegistry.h"
+
+namespace {
+        const int DIRECTIONS[6][3] = {
+                { 1,  0,  0}, {-1,  0,  0},
+                { 0,  1,  0}, { 0, -1,  0},
+                { 0,  0,  1}, { 0,  0, -1},
+        };
+        const int DIRECTION_DOWN = 3;
+
+        bool isOpaque(const Chunk* chunk, int x, int y, int z) {
+                return BlockRegistry::isOpaque(chunk->getBlock(x, y, z));
+        }
+}
+
+bool LightPropagator::step(const Node& from, int direction, Node& to) {
+        to = { from.chunk, from.x + DIRECTIONS[direction][0], from.y + DIRECTIONS[direction][1], from.z + DIRECTIONS[direction][2] };
+        if (to.y < 0 || to.y >= Chunk::CHUNK_HEIGHT) return false;
+
+        if (to.x < 0) { to.chunk = to.chunk->getNeighbour(Chunk::SIDE_NEG_X); to.x += Chunk::CHUNK_SIZE; }
+        else if (to.x >= Chunk::CHUNK_SIZE) { to.chunk = to.chunk->getNeighbour(Chunk::SIDE_POS_X); to.x -= Chunk::CHUNK_SIZE; }
+        else if (to.z < 0) { to.chunk = to.chunk->getNeighbour(Chunk::SIDE_NEG_Z); to.z += Chunk::CHUNK_SIZE; }
+        else if (to.z >= Chunk::CHUNK_SIZE) { to.chunk = to.chunk->getNeighbour(Chunk::SIDE_POS_Z); to.z -= Chunk::CHUNK_SIZE; }
+
+        return to.chunk != nullptr;
+}
+
+void LightPropagator::markDirty(const Node& node) {
+        // The faces sampling this voxel belong to its six neighbours, which may sit in another section or chunk
+        int section = node.y / Chunk::SECTION_HEIGHT;
+        mDirtySections.insert({ node.chunk, section });
+
+        int localY = node.y % Chunk::SECTION_HEIGHT;
+        if (localY == 0 && section > 0) mDirtySections.insert({ node.chunk, section - 1 });
+        if (localY == Chunk::SECTION_HEIGHT - 1 && section < Chunk::SECTION_COUNT - 1) mDirtySections.insert({ node.chunk, section + 1 });
+
+        auto markNeighbour = [&](Chunk::Side side) {
+                if (Chunk* neighbour = node.chunk->getNeighbour(side)) mDirtySections.insert({ neighbour, section });
+        };
+        if (node.x == 0) markNeighbour(Chunk::SIDE_NEG_X);
+        if (node.x == Chunk::CHUNK_SIZE - 1) markNeighbour(Chunk::SIDE_POS_X);
+        if (node.z == 0) markNeighbour(Chunk::SIDE_NEG_Z);
+        if (node.z == Chunk::CHUNK_SIZE - 1) markNeighbour(Chunk::SIDE_POS_Z);
+}
+
+int LightPropagator::sourceLevel(Chunk::LightChannel channel, const Node& node) {
+        if (channel == Chunk::LIGHT_SKY) {
+                return node.y >= node.chunk->getHeight(node.x, node.z) ? Chunk::MAX_LIGHT_LEVEL : 0;
+        }
+        return BlockRegistry::getEmission(node.chunk->getBlock(node.x, node.y, node.z));
+}
+
+bool LightPropagator::canSpread(Chunk::LightChannel channel, const Node& node) {
+        if (channel != Chunk::LIGHT_SKY) return true;
+
+        // Open sky only spreads sideways into a taller neighbouring column; border voxels are
+        // always queued since the neighbour chunk may be taller
+        if (node.x == 0 || node.x == Chunk::CHUNK_SIZE - 1 || node.z == 0 || node.z == Chunk::CHUNK_SIZE - 1) return true;
+        return node.y < node.chunk->getHeight(node.x + 1, node.z) || node.y < node.chunk->getHeight(node.x - 1, node.z)
+            || node.y < node.chunk->getHeight(node.x, node.z + 1) || node.y < node.chunk->getHeight(node.x, node.z - 1);
+}
+
+int LightPropagator::getLight(Chunk::LightChannel channel, const Node& node) const {
+        return node.chunk->getLight(channel, node.x, node.y, node.z);
+}
+
+void LightPropagator::setLight(Chunk::LightChannel channel, const Node& node, int level) {
+        node.chunk->setLight(channel, node.x, node.y, node.z, level);
+        markDirty(node);
+}
+
+void LightPropagator::computeAll(const std::vector<Chunk*>& chunks) {
+        for (int channel = 0; channel < Chunk::LIGHT_CHANNEL_COUNT; channel++) {
+                Chunk::LightChannel lightChannel = (Chunk::LightChannel)channel;
+
+                for (Chunk* chunk : chunks) {
+                        for (int x = 0; x < Chunk::CHUNK_SIZE; x++) {
+                                for (int y = 0; y < Chunk::CHUNK_HEIGHT; y++) {
+                                        for (int z = 0; z < Chunk::CHUNK_SIZE; z++) {
+                                                Node node = { chunk, x, y, z };
+                                                int level = sourceLevel(lightChannel, node);
+                                                chunk->setLight(lightChannel, x, y, z, level);
+                                                if (level > 0 && canSpread(lightChannel, node)) mAddQueue.push_back(node);
+                                        }
+                                }
+                        }
+                }
+
+                propagateAdds(lightChannel);
+        }
+
+        // Every chunk is meshed right after this, nothing is left to remesh
+        mDirtySections.clear();
+}
+
+void LightPropagator::onBlockChanged(Chunk* chunk, int x, int y, int z) {
+        Node node = { chunk, x, y, z };
+        updateChannel(Chunk::LIGHT_BLOCK, node);
+        updateChannel(Chunk::LIGHT_SKY, node);
+}
+
+void LightPropagator::updateChannel(Chunk::LightChannel channel, const Node& node) {
+        // Take out whatever light the voxel held, including light from a removed emitter or a closed column
+        int oldLevel = getLight(channel, node);
+        if (oldLevel > 0) {
+                setLight(channel, node, 0);
+                mRemoveQueue.push_back({ node, oldLevel });
+                propagateRemovals(channel);
+        }
+
+        int source = sourceLevel(channel, node);
+        if (source > 0) {
+                setLight(channel, node, source);
+                mAddQueue.push_back(node);
+        }
+
+        // A voxel that became transparent is filled back in from its lit neighbours
+        if (!isOpaque(node.chunk, node.x, node.y, node.z)) {
+                for (int direction = 0; direction < 6; direction++) {
+                        Node neighbour;
+                        if (step(node, direction, neighbour) && getLight(channel, neighbour) > 1) {
+                                mAddQueue.push_back(neighbour);
+                        }
+                }
+        }
+
+        propagateAdds(channel);
+}
+
+void LightPropagator::propagateRemovals(Chunk::LightChannel channel) {
+        while (!mRemoveQueue.empty()) {
+                RemovalNode current = mRemoveQueue.front();
+                mRemoveQueue.pop_front();
+
+                for (int direction = 0; direction < 6; direction++) {
+                        Node neighbour;
+                        if (!step(current.node, direction, neighbour)) continue;
+
+                        int level = getLight(channel, neighbour);
+                        if (level == 0) continue;
+
+                        // Full sky light below a removed full sky voxel came straight down from it
+                        bool litFromAbove = channel == Chunk::LIGHT_SKY && direction == DIRECTION_DOWN
+                                && current.level == Chunk::MAX_LIGHT_LEVEL && level == Chunk::MAX_LIGHT_LEVEL;
+
+                        if (level < current.level || litFromAbove) {
+                                // Lit by the removed light: clear it, but a source immediately relights itself
+                                setLight(channel, neighbour, 0);
+                                mRemoveQueue.push_back({ neighbour, level });
+
+                                int source = sourceLevel(channel, neighbour);
+                                if (source > 0) {
+                                        setLight(channel, neighbour, source);
+                                        mAddQueue.push_back(neighbour);
+                                }
+                        } else {
+                                // Lit by another source: it refills the cleared area in the add pass
+                                mAddQueue.push_back(neighbour);
+                        }
+                }
+        }
+}
+
+void LightPropagator::propagateAdds(Chunk::LightChannel channel) {
+        while (!mAddQueue.empty()) {
+                Node current = mAddQueue.front();
+                mAddQueue.pop_front();
+
+                int level = getLight(channel, current);
+                if (level <= 1) continue;
+
+                for (int direction = 0; direction < 6; direction++) {
+                        Node neighbour;
+                        if (!step(current, direction, neighbour)) continue;
+                        if (isOpaque(neighbour.chunk, neighbour.x, neighbour.y, neighbour.z)) continue;
+
+                        // Full sky light falls down a column without dimming
+                        bool straightDown = channel == Chunk::LIGHT_SKY && direction == DIRECTION_DOWN && level == Chunk::MAX_LIGHT_LEVEL;
+                        int newLevel = straightDown ? level : level - 1;
+
+                        if (getLight(channel, neighbour) < newLevel) {
+                                setLight(channel, neighbour, newLevel);
+                                mAddQueue.push_back(neighbour);
+                        }
+                }
+        }
+}
+
+LightPropagator::SectionSet LightPropagator::takeDirtySections() {
+        SectionSet dirty;
+        dirty.swap(mDirtySections);
+        return dirty;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <deque>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "Chunk.h"
+
+// Flood-fills the per-voxel light channels (0..15) across chunk borders. Block light is
+// seeded by emissive blocks; sky light by every voxel above its column's heightmap, and
+// travels straight down without losing a level. Otherwise light loses one level per step
+// and never enters opaque blocks. Every changed voxel marks the chunk sections whose faces
+// sample it, so the caller can remesh just those.
+class LightPropagator {
+public:
+        using SectionSet = std::set<std::pair<Chunk*, int>>;
+
+        // Clears and recomputes every channel of every chunk (after world generation)
+        void computeAll(const std::vector<Chunk*>& chunks);
+
+        // Incremental update after the block at (x, y, z) of chunk changed type
+        void onBlockChanged(Chunk* chunk, int x, int y, int z);
+
+        // Sections touched since the last call
+        SectionSet takeDirtySections();
+
+private:
+        struct Node {
+                Chunk* chunk;
+                int x, y, z;
+        };
+        struct RemovalNode {
+                Node node;
+                int level;
+        };
+
+        // Node one step away in the given face direction, false outside the loaded world
+        static bool step(const Node& from, int direction, Node& to);
+        // Level a source voxel holds by itself, regardless of its neighbours
+        static int sourceLevel(Chunk::LightChannel channel, const Node& node);
+        // Whether a freshly seeded source can light anything, to keep the initial sky flood small
+        static bool canSpread(Chunk::LightChannel channel, const Node& node);
+
+        int getLight(Chunk::LightChannel channel, const Node& node) const;
+        void setLight(Chunk::LightChannel channel, const Node& node, int level);
+        void markDirty(const Node& node);
+
+        void updateChannel(Chunk::LightChannel channel, const Node& node);
+        void propagateAdds(Chunk::LightChannel channel);
+        void propagateRemovals(Chunk::LightChannel channel);
+
+        std::deque<Node> mAddQueue;
+        std::deque<RemovalNode> mRemoveQueue;
+        SectionSet mDirtySections;
+};
@@ -1,4 +1,5 @@
 #include "Mesh.h"
+#include "GLState.h"
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -21,7 +22,7 @@ Mesh::Mesh() : mLoaded(false) {
 }
 
 Mesh::~Mesh() {
-        glDeleteVertexArrays(1, &mVAO);
+        GLState::deleteVertexArrays(1, &mVAO);
         glDeleteBuffers(1, &mVBO);
 }
 
@@ -367,9 +368,8 @@ bool Mesh::loadMaterial(const std::string& filename) {
 void Mesh::draw() {
         if(!mLoaded) return;
 
-        glBindVertexArray(mVAO);
+        GLState::bindVertexArray(mVAO);
         glDrawArrays(GL_TRIANGLES, 0, mVertices.size());
-        glBindVertexArray(0);
 }
 
 void Mesh::drawSubMesh(const std::string& materialName) {
@@ -380,9 +380,8 @@ void Mesh::drawSubMesh(const std::string& materialName) {
 
         const SubMesh& subMesh = it->second;
 
-        glBindVertexArray(mVAO);
+        GLState::bindVertexArray(mVAO);
         glDrawArrays(GL_TRIANGLES, subMesh.startIndex, subMesh.indexCount);
-        glBindVertexArray(0);
 }
 
 const std::map<std::string, SubMesh>& Mesh::getSubMeshes() const {
@@ -405,7 +404,7 @@ void Mesh::initBuffers() {
         glGenVertexArrays(1, &mVAO);
         glGenBuffers(1, &mVBO);
 
-        glBindVertexArray(mVAO);
+        GLState::bindVertexArray(mVAO);
         glBindBuffer(GL_ARRAY_BUFFER, mVBO);
         glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), &mVertices[0], GL_STATIC_DRAW);
 
@@ -421,5 +420,5 @@ void Mesh::initBuffers() {
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, texCoords)));
         glEnableVertexAttribArray(2);
 
-        glBindVertexArray(0);
+        GLState::bindVertexArray(0);
 }
\ No newline at end of file
@@ -58,6 +58,10 @@ class Mesh {
                 const std::map<std::string, Material>& getMaterials() const;
                 const Material* getMaterial(const std::string& name) const;
 
+                // Raw draw data for the render queue; 0 vertices when loading failed
+                GLuint getVAO() const { return mVAO; }
+                GLsizei getVertexCount() const { return mLoaded ? (GLsizei)mVertices.size() : 0; }
+
                 glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
                 glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
 
@@ -0,0 +1,227 @@
+#include "OcclusionCuller.h"
+#include "World.h"
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace {
+    // Corners closer than this (clip w) would need clipping: such occluders are skipped and
+    // such sections count as visible
+    const float MIN_CLIP_W = 0.1f;
+
+    // Box corner i picks max on x, y, z for bits 0, 1, 2
+    glm::vec3 boxCorner(const glm::vec3& boxMin, const glm::vec3& boxMax, int i) {
+        return glm::vec3((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+    }
+
+    // Per face: outward axis and sign, then its four corners in order around the face
+    struct BoxFace {
+        int axis;
+        float sign;
+        int corners[4];
+    };
+    const BoxFace BOX_FACES[6] = {
+        { 0, -1.0f, { 0, 2, 6, 4 } }, { 0, 1.0f, { 1, 5, 7, 3 } },
+        { 1, -1.0f, { 0, 4, 5, 1 } }, { 1, 1.0f, { 2, 3, 7, 6 } },
+        { 2, -1.0f, { 0, 1, 3, 2 } }, { 2, 1.0f, { 4, 6, 7, 5 } },
+    };
+}
+
+OcclusionCuller::OcclusionCuller() {
+    mDepth.assign(DEPTH_WIDTH * DEPTH_HEIGHT, 1.0f);
+    mWorker = std::thread(&OcclusionCuller::workerLoop, this);
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQuit = true;
+    }
+    mWake.notify_one();
+    mWorker.join();
+}
+
+void OcclusionCuller::begin(const World& world, const glm::mat4& viewProjection, const glm::vec3& eye) {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mWorld = &world;
+        mViewProjection = viewProjection;
+        mEye = eye;
+        mJobPending = true;
+        mJobQueued = true;
+    }
+    mWake.notify_one();
+}
+
+void OcclusionCuller::wait() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this] { return !mJobPending; });
+}
+
+void OcclusionCuller::workerLoop() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mWake.wait(lock, [this] { return mJobQueued || mQuit; });
+        if (mQuit) return;
+        mJobQueued = false;
+
+        lock.unlock();
+        run();
+        lock.lock();
+
+        mJobPending = false;
+        mDone.notify_all();
+    }
+}
+
+void OcclusionCuller::run() {
+    const std::vector<Chunk*>& chunks = mWorld->getChunks();
+    std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+    mOccluded.assign(chunks.size() * Chunk::SECTION_COUNT, 0);
+    mOccluderCount = 0;
+    mTestedCount = 0;
+    mOccludedCount = 0;
+
+    // Blocks are centred on integer coordinates, so local block b spans [b - 0.5, b + 0.5]
+    for (const Chunk* chunk : chunks) {
+        glm::vec3 origin = chunk->getWorldPosition() - glm::vec3(0.5f);
+        for (const Chunk::OccluderBox& box : chunk->getOccluders()) {
+            rasterizeBox(origin + glm::vec3(box.min), origin + glm::vec3(box.max));
+        }
+    }
+
+    for (int chunkIndex = 0; chunkIndex < (int)chunks.size(); chunkIndex++) {
+        const Chunk* chunk = chunks[chunkIndex];
+        glm::vec3 origin = chunk->getWorldPosition() - glm::vec3(0.5f);
+        for (int section = 0; section < Chunk::SECTION_COUNT; section++) {
+            if (chunk->getSectionVertexCount(section) == 0) continue;
+
+            glm::vec3 boxMin = origin + glm::vec3(0.0f, (float)(section * Chunk::SECTION_HEIGHT), 0.0f);
+            glm::vec3 boxMax = boxMin + glm::vec3((float)Chunk::CHUNK_SIZE, (float)Chunk::SECTION_HEIGHT, (float)Chunk::CHUNK_SIZE);
+            bool onScreen = false;
+            if (isBoxOccluded(boxMin, boxMax, onScreen)) {
+                mOccluded[chunkIndex * Chunk::SECTION_COUNT + section] = 1;
+                mOccludedCount++;
+            }
+            if (onScreen) mTestedCount++;
+        }
+    }
+}
+
+void OcclusionCuller::rasterizeBox(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    ScreenVertex screen[8];
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 clip = mViewProjection * glm::vec4(boxCorner(boxMin, boxMax, i), 1.0f);
+        if (clip.w < MIN_CLIP_W) return;
+        float invW = 1.0f / clip.w;
+        screen[i] = { (clip.x * invW * 0.5f + 0.5f) * DEPTH_WIDTH, (clip.y * invW * 0.5f + 0.5f) * DEPTH_HEIGHT, clip.z * invW };
+    }
+    mOccluderCount++;
+
+    // Only the faces turned towards the eye; they cover the box's whole silhouette
+    for (const BoxFace& face : BOX_FACES) {
+        float plane = face.sign > 0.0f ? boxMax[face.axis] : boxMin[face.axis];
+        if ((mEye[face.axis] - plane) * face.sign <= 0.0f) continue;
+
+        const int* c = face.corners;
+        rasterizeTriangle(screen[c[0]], screen[c[1]], screen[c[2]]);
+        rasterizeTriangle(screen[c[0]], screen[c[2]], screen[c[3]]);
+    }
+}
+
+void OcclusionCuller::rasterizeTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2) {
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (std::fabs(area) < 1e-6f) return;
+
+    int minX = std::max((int)std::floor(std::min({ v0.x, v1.x, v2.x })), 0);
+    int maxX = std::min((int)std::ceil(std::max({ v0.x, v1.x, v2.x })), DEPTH_WIDTH - 1);
+    int minY = std::max((int)std::floor(std::min({ v0.y, v1.y, v2.y })), 0);
+    int maxY = std::min((int)std::ceil(std::max({ v0.y, v1.y, v2.y })), DEPTH_HEIGHT - 1);
+    if (minX > maxX || minY > maxY) return;
+
+    // Edge functions e = a * x + b * y + c, each zero on the edge opposite a vertex and
+    // positive inside whichever way the triangle winds
+    const ScreenVertex* v[3] = { &v0, &v1, &v2 };
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    float a[3], b[3], c[3];
+    for (int i = 0; i < 3; i++) {
+        const ScreenVertex& p = *v[(i + 1) % 3];
+        const ScreenVertex& q = *v[(i + 2) % 3];
+        a[i] = (p.y - q.y) * sign;
+        b[i] = (q.x - p.x) * sign;
+        c[i] = (p.x * q.y - q.x * p.y) * sign;
+    }
+
+    // Depth is linear in screen space: z = za * x + zb * y + zc
+    float invArea = 1.0f / std::fabs(area);
+    float za = (a[0] * v0.z + a[1] * v1.z + a[2] * v2.z) * invArea;
+    float zb = (b[0] * v0.z + b[1] * v1.z + b[2] * v2.z) * invArea;
+    float zc = (c[0] * v0.z + c[1] * v1.z + c[2] * v2.z) * invArea;
+
+    const __m128 laneX = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f); // Pixel centres
+    const __m128 zero = _mm_setzero_ps();
+    __m128 a0 = _mm_set1_ps(a[0]), a1 = _mm_set1_ps(a[1]), a2 = _mm_set1_ps(a[2]);
+    __m128 zA = _mm_set1_ps(za);
+
+    int startX = minX & ~3;
+    for (int y = minY; y <= maxY; y++) {
+        float py = y + 0.5f;
+        __m128 row0 = _mm_set1_ps(b[0] * py + c[0]);
+        __m128 row1 = _mm_set1_ps(b[1] * py + c[1]);
+        __m128 row2 = _mm_set1_ps(b[2] * py + c[2]);
+        __m128 rowZ = _mm_set1_ps(zb * py + zc);
+        float* depthRow = &mDepth[y * DEPTH_WIDTH];
+
+        for (int x = startX; x <= maxX; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneX);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), row0);
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), row1);
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), row2);
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+            if (_mm_movemask_ps(inside) == 0) continue;
+
+            __m128 z = _mm_add_ps(_mm_mul_ps(zA, px), rowZ);
+            __m128 depth = _mm_loadu_ps(depthRow + x);
+            __m128 nearer = _mm_min_ps(depth, z);
+            _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, depth)));
+        }
+    }
+}
+
+bool OcclusionCuller::isBoxOccluded(const glm::vec3& boxMin, const glm::vec3& boxMax, bool& onScreen) const {
+    onScreen = false;
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, nearestZ = 1e30f;
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 clip = mViewProjection * glm::vec4(boxCorner(boxMin, boxMax, i), 1.0f);
+        if (clip.w < MIN_CLIP_W) {
+            onScreen = true;
+            return false; // Reaches the eye
+        }
+        float invW = 1.0f / clip.w;
+        float x = (clip.x * invW * 0.5f + 0.5f) * DEPTH_WIDTH;
+        float y = (clip.y * invW * 0.5f + 0.5f) * DEPTH_HEIGHT;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearestZ = std::min(nearestZ, clip.z * invW);
+    }
+
+    // Every pixel the box may touch, whole SSE groups at a time (extra pixels only make it more visible)
+    int x0 = std::max((int)std::floor(minX), 0) & ~3;
+    int x1 = std::min((int)std::ceil(maxX), DEPTH_WIDTH - 1);
+    int y0 = std::max((int)std::floor(minY), 0);
+    int y1 = std::min((int)std::ceil(maxY), DEPTH_HEIGHT - 1);
+    if (x0 > x1 || y0 > y1) return false; // Off screen, left to frustum culling
+    onScreen = true;
+
+    __m128 boxZ = _mm_set1_ps(nearestZ);
+    for (int y = y0; y <= y1; y++) {
+        const float* depthRow = &mDepth[y * DEPTH_WIDTH];
+        for (int x = x0; x <= x1; x += 4) {
+            if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(depthRow + x), boxZ)) != 0) return false;
+        }
+    }
+    return true;
+}
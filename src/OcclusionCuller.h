@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Chunk.h"
+
+class World;
+
+// Software occlusion culling on a worker thread. The chunks' solid occluder boxes are
+// rasterized with SSE into a small depth buffer, then every chunk section's box is tested
+// against it; sections whose box is behind the rasterized depth everywhere are occluded.
+// begin() hands the frame to the worker, which runs while the main thread issues the shadow
+// passes and the GPU finishes the previous frame; wait() collects the result.
+class OcclusionCuller {
+public:
+    static const int DEPTH_WIDTH = 256; // Multiple of 4, one SSE register per 4 pixels
+    static const int DEPTH_HEIGHT = 128;
+
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    // The world must not change until wait() returns
+    void begin(const World& world, const glm::mat4& viewProjection, const glm::vec3& eye);
+    // Blocks until the job started by the last begin() is done; no-op without one
+    void wait();
+
+    // chunkIndex is the chunk's position in World::getChunks(). Valid after wait().
+    bool isOccluded(int chunkIndex, int section) const { return mOccluded[chunkIndex * Chunk::SECTION_COUNT + section] != 0; }
+
+    // Of the last frame: occluder boxes drawn, sections tested on screen and found occluded
+    int getOccluderCount() const { return mOccluderCount; }
+    int getTestedCount() const { return mTestedCount; }
+    int getOccludedCount() const { return mOccludedCount; }
+
+private:
+    struct ScreenVertex {
+        float x, y, z; // Depth buffer pixels, NDC depth
+    };
+
+    void workerLoop();
+    void run();
+
+    void rasterizeBox(const glm::vec3& boxMin, const glm::vec3& boxMax);
+    void rasterizeTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2);
+    // False when some pixel of the box's screen rectangle is not in front of its nearest point
+    bool isBoxOccluded(const glm::vec3& boxMin, const glm::vec3& boxMax, bool& onScreen) const;
+
+    std::thread mWorker;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    bool mJobPending = false; // begin() called, wait() not yet returned
+    bool mJobQueued = false;  // Not picked up by the worker yet
+    bool mQuit = false;
+
+    // Job input, only touched by the worker between begin() and wait()
+    const World* mWorld = nullptr;
+    glm::mat4 mViewProjection = glm::mat4(1.0f);
+    glm::vec3 mEye = glm::vec3(0.0f);
+
+    std::vector<float> mDepth; // NDC depth, 1 is empty
+    std::vector<unsigned char> mOccluded;
+    int mOccluderCount = 0;
+    int mTestedCount = 0;
+    int mOccludedCount = 0;
+};
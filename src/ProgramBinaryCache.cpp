@@ -0,0 +1,140 @@
+#include "ProgramBinaryCache.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+        const uint32_t CACHE_MAGIC = 0x31434250; // "PBC1"
+
+        struct CacheHeader {
+                uint32_t magic;
+                uint32_t format;
+                uint32_t length;
+                uint32_t pad;
+                uint64_t key;
+        };
+
+        // FNV-1a, stable across runs and compilers unlike std::hash
+        uint64_t hashBytes(uint64_t hash, const std::string& data) {
+                for (unsigned char c : data) {
+                        hash ^= c;
+                        hash *= 1099511628211ull;
+                }
+                return hash;
+        }
+
+        std::string glString(GLenum name) {
+                const GLubyte* value = glGetString(name);
+                return value ? reinterpret_cast<const char*>(value) : "";
+        }
+}
+
+std::string ProgramBinaryCache::sDirectory = "./shader_cache";
+bool ProgramBinaryCache::sEnabled = true;
+int ProgramBinaryCache::sHits = 0;
+int ProgramBinaryCache::sMisses = 0;
+
+bool ProgramBinaryCache::isAvailable() {
+        if (!sEnabled) return false;
+
+        // Queried once: the context does not change during the run
+        static const bool supported = [] {
+                if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) return false;
+                GLint formatCount = 0;
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+                return formatCount > 0;
+        }();
+        return supported;
+}
+
+uint64_t ProgramBinaryCache::makeKey(const std::string& vsSource, const std::string& fsSource, const std::string& gsSource) {
+        // Any driver update changes the version string and therefore every key
+        static const std::string driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+
+        uint64_t hash = 14695981039346656037ull;
+        hash = hashBytes(hash, driver);
+        hash = hashBytes(hash, vsSource);
+        hash = hashBytes(hash, "\x1f");
+        hash = hashBytes(hash, fsSource);
+        if (!gsSource.empty()) {
+                hash = hashBytes(hash, "\x1f");
+                hash = hashBytes(hash, gsSource);
+        }
+        return hash;
+}
+
+std::string ProgramBinaryCache::pathFor(uint64_t key) {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+        return (std::filesystem::path(sDirectory) / name).string();
+}
+
+void ProgramBinaryCache::prepareForLink(GLuint program) {
+        if (!isAvailable()) return;
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool ProgramBinaryCache::load(uint64_t key, GLuint program) {
+        if (!isAvailable()) return false;
+
+        std::ifstream file(pathFor(key), std::ios::binary);
+        if (!file) {
+                sMisses++;
+                return false;
+        }
+
+        CacheHeader header = {};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        std::vector<char> binary(file ? header.length : 0);
+        if (file && header.magic == CACHE_MAGIC && header.key == key) {
+                file.read(binary.data(), binary.size());
+        }
+
+        if (!file || header.magic != CACHE_MAGIC || header.key != key || binary.empty()) {
+                sMisses++;
+                return false;
+        }
+
+        glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+
+        // The driver may still reject a binary it produced, e.g. after a silent update
+        GLint status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status != GL_TRUE) {
+                file.close();
+                std::error_code ec;
+                std::filesystem::remove(pathFor(key), ec);
+                sMisses++;
+                return false;
+        }
+
+        sHits++;
+        return true;
+}
+
+void ProgramBinaryCache::store(uint64_t key, GLuint program) {
+        if (!isAvailable()) return;
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        std::error_code ec;
+        std::filesystem::create_directories(sDirectory, ec);
+
+        std::ofstream file(pathFor(key), std::ios::binary | std::ios::trunc);
+        if (!file) {
+                std::cerr << "Could not write program binary cache to " << sDirectory << std::endl;
+                return;
+        }
+
+        CacheHeader header = { CACHE_MAGIC, format, (uint32_t)length, 0, key };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+}
@@ -0,0 +1,41 @@
+#ifndef PROGRAM_BINARY_CACHE_H
+#define PROGRAM_BINARY_CACHE_H
+
+#ifndef GLEW_STATIC
+#define GLEW_STATIC
+#endif
+#include "GL/glew.h"
+#include <cstdint>
+#include <string>
+
+// Linked program binaries on disk, keyed by the final sources (defines included) and the driver.
+// Anything that does not match exactly falls back to compiling from source.
+class ProgramBinaryCache {
+    public:
+        static void setDirectory(const std::string& directory) { sDirectory = directory; }
+        static void setEnabled(bool enabled) { sEnabled = enabled; }
+
+        // False when disabled or when the context exposes no binary format
+        static bool isAvailable();
+
+        static uint64_t makeKey(const std::string& vsSource, const std::string& fsSource, const std::string& gsSource = "");
+
+        // Call before glLinkProgram so the driver keeps the binary around
+        static void prepareForLink(GLuint program);
+
+        static bool load(uint64_t key, GLuint program);
+        static void store(uint64_t key, GLuint program);
+
+        static int getHits() { return sHits; }
+        static int getMisses() { return sMisses; }
+
+    private:
+        static std::string pathFor(uint64_t key);
+
+        static std::string sDirectory;
+        static bool sEnabled;
+        static int sHits;
+        static int sMisses;
+};
+
+#endif
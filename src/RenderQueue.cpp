@@ -0,0 +1,71 @@
+#include "RenderQueue.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cstring>
+
+void RenderQueue::begin(const glm::vec3& eye, float maxDepth) {
+    mCommands.clear(); // Keeps the capacity, no allocation after the first frames
+    mEye = eye;
+    mMaxDepth = glm::max(maxDepth, 1.0f);
+}
+
+uint64_t RenderQueue::makeKey(Layer layer, float depth01, GLuint program, GLuint texture, GLint material) {
+    uint64_t depthBits = (uint64_t)(glm::clamp(depth01, 0.0f, 1.0f) * 65535.0f);
+    if (layer == LAYER_TRANSLUCENT) {
+        depthBits = 65535 - depthBits;
+    }
+
+    // GL names are small integers in practice; truncation only weakens grouping, never correctness
+    return ((uint64_t)layer << 63)
+         | (depthBits << 47)
+         | ((uint64_t)(program & 0xFF) << 39)
+         | ((uint64_t)(texture & 0xFFFF) << 23)
+         | ((uint64_t)(material & 0xFF) << 15);
+}
+
+void RenderQueue::submit(DrawCommand command, const glm::vec3& center, Layer layer) {
+    if (command.count <= 0 || !command.program) return;
+
+    float depth01 = glm::length(center - mEye) / mMaxDepth;
+    command.key = makeKey(layer, depth01, command.program->getProgram(), command.texture, command.material);
+    mCommands.push_back(command);
+}
+
+void RenderQueue::sort() {
+    std::sort(mCommands.begin(), mCommands.end(),
+              [](const DrawCommand& a, const DrawCommand& b) { return a.key < b.key; });
+}
+
+void RenderQueue::execute() const {
+    const ShaderProgram* lastProgram = nullptr;
+    const glm::mat4* lastModel = nullptr;
+    GLint lastMaterial = -1;
+
+    for (const DrawCommand& cmd : mCommands) {
+        bool programChanged = cmd.program != lastProgram;
+        if (programChanged) {
+            cmd.program->use();
+            lastProgram = cmd.program;
+            lastModel = nullptr;
+            lastMaterial = -1;
+        }
+
+        // Consecutive draws often share a transform (all chunk sections use identity)
+        if (!lastModel || std::memcmp(lastModel, &cmd.model, sizeof(glm::mat4)) != 0) {
+            cmd.program->setUniform(cmd.modelUniform, cmd.model);
+            lastModel = &cmd.model;
+        }
+
+        if (cmd.materialUniform.isValid() && cmd.material != lastMaterial) {
+            cmd.program->setUniform(cmd.materialUniform, cmd.material);
+            lastMaterial = cmd.material;
+        }
+
+        if (cmd.texture) {
+            GLState::bindTexture(cmd.textureUnit, cmd.textureTarget, cmd.texture);
+        }
+
+        GLState::bindVertexArray(cmd.vao);
+        glDrawArrays(cmd.mode, cmd.first, cmd.count);
+    }
+}
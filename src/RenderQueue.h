@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "ShaderProgram.h"
+
+// One recorded draw. Everything needed to issue it is captured so the list can be sorted freely.
+struct DrawCommand {
+    uint64_t key = 0;
+
+    ShaderProgram* program = nullptr;
+    ShaderProgram::Uniform<glm::mat4> modelUniform;
+    glm::mat4 model = glm::mat4(1.0f);
+
+    // Optional per-draw integer switch (e.g. useModelTexture), skipped when the handle is invalid
+    ShaderProgram::Uniform<GLint> materialUniform;
+    GLint material = 0;
+
+    // Optional texture, 0 leaves the unit as the pass bound it
+    GLuint texture = 0;
+    GLenum textureTarget = GL_TEXTURE_2D;
+    GLuint textureUnit = 0;
+
+    GLuint vao = 0;
+    GLenum mode = GL_TRIANGLES;
+    GLint first = 0;
+    GLsizei count = 0;
+};
+
+// Per-pass draw list, sorted by a packed 64-bit key before one execution sweep:
+//   [63]     layer (opaque first)
+//   [62..47] quantized view depth, front-to-back for opaque (early-Z), back-to-front for translucent
+//   [46..39] program, [38..23] texture, [22..15] material: ties are grouped by state
+class RenderQueue {
+public:
+    enum Layer { LAYER_OPAQUE = 0, LAYER_TRANSLUCENT = 1 };
+
+    // Depths are quantized over [0, maxDepth]; anything further shares the last bucket
+    void begin(const glm::vec3& eye, float maxDepth);
+    void submit(DrawCommand command, const glm::vec3& center, Layer layer = LAYER_OPAQUE);
+    void sort();
+    void execute() const;
+
+    size_t size() const { return mCommands.size(); }
+
+    static uint64_t makeKey(Layer layer, float depth01, GLuint program, GLuint texture, GLint material);
+
+private:
+    std::vector<DrawCommand> mCommands;
+    glm::vec3 mEye = glm::vec3(0.0f);
+    float mMaxDepth = 1.0f;
+};
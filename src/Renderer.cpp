@@ -1,9 +1,229 @@
 #include "Renderer.h"
+#include "GLState.h"
 #include "Constants.h"
 #include "Chunk.h"
+#include "BlockRegistry.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/rotate_vector.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
+#include <limits>
+
+namespace {
+    // std140 mirror of BlockMaterialUniform in minecraft.frag, shadow_dir.frag and depth_point.frag
+    struct BlockMaterialStd140 {
+        glm::vec3 ambient;
+        GLint flags; // LayerFlags, packed into the slot after ambient
+        glm::vec3 specular;
+        float shininess;
+    };
+    static_assert(sizeof(BlockMaterialStd140) == 32, "BlockMaterialStd140 must match the std140 layout");
+
+    // std140 mirror of the FrameData block (minecraft.vert/.frag, debug_line.vert)
+    struct FrameDataStd140 {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec3 viewPos;
+        float pad0;
+    };
+    static_assert(sizeof(FrameDataStd140) == 144, "FrameDataStd140 must match the std140 layout");
+
+    // std140 mirrors of the light structs in minecraft.frag: every vec3 starts a new 16-byte slot
+    struct DirectionalLightStd140 {
+        glm::vec3 direction; float pad0;
+        glm::vec3 ambient; float pad1;
+        glm::vec3 diffuse; float pad2;
+        glm::vec3 specular; float pad3;
+    };
+    static_assert(sizeof(DirectionalLightStd140) == 64, "DirectionalLightStd140 must match the std140 layout");
+
+    struct SpotLightStd140 {
+        glm::vec3 position; float pad0;
+        glm::vec3 direction; float pad1;
+        glm::vec3 ambient; float pad2;
+        glm::vec3 diffuse; float pad3;
+        glm::vec3 specular;
+        float constant;
+        float linear;
+        float exponant;
+        float cosInnerCone;
+        float cosOuterCone;
+    };
+    static_assert(sizeof(SpotLightStd140) == 96, "SpotLightStd140 must match the std140 layout");
+
+    // Point lights are not in the block: they go through the cluster buffer textures
+    struct LightsStd140 {
+        DirectionalLightStd140 dirLight;
+        SpotLightStd140 spotLights[MAX_SPOT_LIGHTS];
+        glm::mat4 spotLightSpaceMatrices[MAX_SPOT_LIGHTS];
+        int numPointLights;
+        int numSpotLights;
+        float pointFarPlane;
+        int numPointShadows;
+        glm::vec4 clusterParams;
+        glm::vec4 pointShadowTiles[MAX_POINT_SHADOWS * 6];
+        glm::vec4 spotShadowTiles[MAX_SPOT_LIGHTS];
+        glm::mat4 dirLightSpaceMatrices[DIR_SHADOW_CASCADES];
+        glm::vec4 cascadeSplits;
+        glm::vec4 cascadeDepthBias;
+    };
+    static_assert(offsetof(LightsStd140, clusterParams) == 64 + 96 * MAX_SPOT_LIGHTS + 64 * MAX_SPOT_LIGHTS + 16,
+                  "LightsStd140 must match the std140 layout");
+
+    // Light counts are rounded up to a power of two so a handful of variants cover every frame
+    int lightBucket(int count, int maxCount) {
+        if (count <= 0) return 0;
+        int bucket = 1;
+        while (bucket < count) bucket *= 2;
+        return glm::min(bucket, maxCount);
+    }
+
+    // Texture units used by the world passes
+    const int BLOCK_TEXTURE_UNIT = 0;
+    const int MODEL_TEXTURE_UNIT = 1;
+    const int FIRST_SHADOW_TEXTURE_UNIT = 2; // dir cascade array, then the point and spot shadow atlas
+    const int POINT_LIGHT_DATA_UNIT = FIRST_SHADOW_TEXTURE_UNIT + 2;
+    const int CLUSTER_GRID_UNIT = POINT_LIGHT_DATA_UNIT + 1;
+    const int CLUSTER_LIGHT_INDEX_UNIT = POINT_LIGHT_DATA_UNIT + 2;
+    const int FIRST_GBUFFER_UNIT = CLUSTER_LIGHT_INDEX_UNIT + 1; // albedo, normal, lighting, depth
+
+    // Must match the projection used by the main pass
+    const float MAIN_NEAR_PLANE = 0.1f;
+    const float MAIN_FAR_PLANE = 200.0f;
+
+    // Shadow update scheduling. Stale local tiles are redrawn within a per-frame texel budget
+    // (one full-size point light); tiles with nothing usable in them are always drawn.
+    const long long SHADOW_UPDATE_TEXEL_BUDGET = 6LL * 1024 * 1024;
+    // Lights this small on screen (a minimum size tile) only refresh every few frames
+    const float FAR_LIGHT_IMPORTANCE = 0.125f;
+    const unsigned int FAR_LIGHT_UPDATE_INTERVAL = 8;
+    // A sun cascade is reused until the sun turns this much or its snapped centre moves
+    const float SUN_UPDATE_ANGLE = glm::radians(0.5f);
+
+    // Sun cascades split the view depth up to the main far plane, blending logarithmic splits
+    // (even texel density) with uniform ones (less crowding near the camera)
+    const float CASCADE_SPLIT_LAMBDA = 0.8f;
+    // Casters this far beyond a cascade's bounding sphere, towards the sun, still cast into it
+    const float DIR_SHADOW_CASTER_MARGIN = 64.0f;
+    const float DIR_SHADOW_BIAS_TEXELS = 2.0f;
+
+    // Chunk section bounds around getSectionCenter, padded for blocks centred on the section edges
+    const glm::vec3 SECTION_HALF_EXTENT(Chunk::CHUNK_SIZE * 0.5f + 1.0f, Chunk::SECTION_HEIGHT * 0.5f + 1.0f, Chunk::CHUNK_SIZE * 0.5f + 1.0f);
+
+    // Cube map faces in GL_TEXTURE_CUBE_MAP_POSITIVE_X + i order
+    const glm::vec3 CUBE_FACE_DIRECTIONS[6] = {
+        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+    };
+    const glm::vec3 CUBE_FACE_UPS[6] = {
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+    };
+    const int ALL_CUBE_FACES = 0x3F;
+
+    // Share of the screen height covered by a sphere, 1 once the eye is inside it
+    float projectedSize(const glm::vec3& center, float radius, const glm::vec3& eye, float fovY) {
+        float distance = glm::length(center - eye);
+        if (distance <= radius) return 1.0f;
+        return glm::min(1.0f, radius / (distance * std::tan(fovY * 0.5f)));
+    }
+
+    // Atlas tile as xy centre and zw half size in the atlas viewport's NDC
+    glm::vec4 atlasTileNDC(const ShadowAtlas::Tile& tile) {
+        float halfSize = (float)tile.size / SHADOW_ATLAS_SIZE;
+        return glm::vec4((tile.x * 2.0f) / SHADOW_ATLAS_SIZE - 1.0f + halfSize,
+                         (tile.y * 2.0f) / SHADOW_ATLAS_SIZE - 1.0f + halfSize, halfSize, halfSize);
+    }
+
+    // Expects GL_SCISSOR_TEST to be enabled
+    void clearAtlasTile(const ShadowAtlas::Tile& tile) {
+        glScissor(tile.x, tile.y, tile.size, tile.size);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    // Conservative: true only when all eight corners are outside the same clip plane
+    bool boxOutsideClipVolume(const glm::mat4& clipFromWorld, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+        glm::vec4 clip[8];
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec3 point((corner & 1) ? boxMax.x : boxMin.x, (corner & 2) ? boxMax.y : boxMin.y, (corner & 4) ? boxMax.z : boxMin.z);
+            clip[corner] = clipFromWorld * glm::vec4(point, 1.0f);
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            bool allBelow = true, allAbove = true;
+            for (const glm::vec4& c : clip) {
+                if (c[axis] >= -c.w) allBelow = false;
+                if (c[axis] <= c.w) allAbove = false;
+            }
+            if (allBelow || allAbove) return true;
+        }
+        return false;
+    }
+
+    // Far view depth of cascade i (0-based)
+    float cascadeSplit(int i) {
+        float t = (float)(i + 1) / DIR_SHADOW_CASCADES;
+        float logSplit = MAIN_NEAR_PLANE * std::pow(MAIN_FAR_PLANE / MAIN_NEAR_PLANE, t);
+        float uniformSplit = MAIN_NEAR_PLANE + (MAIN_FAR_PLANE - MAIN_NEAR_PLANE) * t;
+        return CASCADE_SPLIT_LAMBDA * logSplit + (1.0f - CASCADE_SPLIT_LAMBDA) * uniformSplit;
+    }
+
+    bool sphereIntersectsBox(const glm::vec3& center, float radius, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+        glm::vec3 delta = center - glm::clamp(center, boxMin, boxMax);
+        return glm::dot(delta, delta) <= radius * radius;
+    }
+
+    glm::mat4 modelMatrix(const Model& model) {
+        glm::mat4 matrix = glm::translate(glm::mat4(1.0f), model.position);
+        matrix = glm::rotate(matrix, glm::radians(model.rotation.angle), model.rotation.axis);
+        return glm::scale(matrix, model.scale);
+    }
+
+    // World-space box around the transformed corners of the mesh's local box
+    bool modelWorldBounds(const Model& model, const std::map<std::string, std::unique_ptr<Mesh>>& meshCache,
+                          glm::vec3& boxMin, glm::vec3& boxMax) {
+        auto meshIt = meshCache.find(model.meshFile);
+        if (meshIt == meshCache.end()) return false;
+        const Mesh& mesh = *meshIt->second;
+
+        glm::mat4 matrix = modelMatrix(model);
+        boxMin = glm::vec3(std::numeric_limits<float>::max());
+        boxMax = glm::vec3(std::numeric_limits<float>::lowest());
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec3 local((corner & 1) ? mesh.max.x : mesh.min.x,
+                            (corner & 2) ? mesh.max.y : mesh.min.y,
+                            (corner & 4) ? mesh.max.z : mesh.min.z);
+            glm::vec3 world = glm::vec3(matrix * glm::vec4(local, 1.0f));
+            boxMin = glm::min(boxMin, world);
+            boxMax = glm::max(boxMax, world);
+        }
+        return true;
+    }
+
+    // Cube faces whose 90 degree frustum may overlap the box (conservative), 0 when the box is out of range
+    int cubeFaceMask(const glm::vec3& lightPos, const glm::vec3& boxMin, const glm::vec3& boxMax, float range) {
+        glm::vec3 lo = boxMin - lightPos;
+        glm::vec3 hi = boxMax - lightPos;
+        // Smallest |coordinate| over the box on each axis, 0 when the box straddles the light
+        glm::vec3 nearest = glm::max(glm::max(lo, -hi), glm::vec3(0.0f));
+        if (glm::dot(nearest, nearest) > range * range) return 0;
+
+        int mask = 0;
+        for (int face = 0; face < 6; face++) {
+            int axis = face / 2;
+            float reach = (face % 2 == 0) ? hi[axis] : -lo[axis];
+            if (reach <= 0.0f) continue;
+            // Inside the face frustum, the face axis dominates both other axes
+            if (reach >= nearest[(axis + 1) % 3] && reach >= nearest[(axis + 2) % 3]) {
+                mask |= 1 << face;
+            }
+        }
+        return mask;
+    }
+}
 
 Renderer::Renderer() {
     m_dirLight = {
@@ -20,18 +240,19 @@ Renderer::Renderer() {
 }
 
 Renderer::~Renderer() {
-    glDeleteFramebuffers(1, &m_dirShadowMapFBO);
-    glDeleteTextures(1, &m_dirShadowMap);
-    glDeleteFramebuffers(1, &m_pointShadowMapFBO);
-    glDeleteTextures(1, &m_pointShadowMap);
-    if (!m_spotShadowMapFBOs.empty()) {
-        glDeleteFramebuffers(m_spotShadowMapFBOs.size(), m_spotShadowMapFBOs.data());
-        glDeleteTextures(m_spotShadowMaps.size(), m_spotShadowMaps.data());
-    }
-
-    if (m_crosshairVAO) glDeleteVertexArrays(1, &m_crosshairVAO);
+    GLState::deleteFramebuffers(1, &m_dirShadowMapFBO);
+    GLState::deleteTextures(1, &m_dirShadowMaps);
+    GLState::deleteFramebuffers(1, &m_shadowAtlasFBO);
+    GLState::deleteTextures(1, &m_shadowAtlasTexture);
+    if (m_fragmentQueries[0]) glDeleteQueries(FRAGMENT_QUERY_FRAMES, m_fragmentQueries);
+    GLState::deleteFramebuffers(1, &m_gBufferFBO);
+    GLState::deleteTextures(GBUFFER_TARGETS, m_gBufferTextures);
+    GLState::deleteTextures(1, &m_gBufferDepth);
+    if (m_fullscreenVAO) GLState::deleteVertexArrays(1, &m_fullscreenVAO);
+
+    if (m_crosshairVAO) GLState::deleteVertexArrays(1, &m_crosshairVAO);
     if (m_crosshairVBO) glDeleteBuffers(1, &m_crosshairVBO);
-    if (m_guiVAO) glDeleteVertexArrays(1, &m_guiVAO);
+    if (m_guiVAO) GLState::deleteVertexArrays(1, &m_guiVAO);
     if (m_guiVBO) glDeleteBuffers(1, &m_guiVBO);
 }
 
@@ -40,111 +261,368 @@ void Renderer::init() {
     initShadows();
     initCrosshair();
     initGUIMesh();
+    initUniformBuffers();
+    initQueries();
 }
 
 void Renderer::initShaders() {
-    m_minecraftShader = std::make_unique<ShaderProgram>();
-    m_minecraftShader->loadShaders("./minecraft.vert", "./minecraft.frag");
+    m_hasCutoutLayers = BlockRegistry::anyLayerHasFlags(LAYER_CUTOUT);
+
+    m_minecraftVariants = std::make_unique<ShaderVariantCache>("./minecraft.vert", "./minecraft.frag",
+        [this](ShaderProgram& program) { setupMainProgram(program); });
+    // Same lighting code built with DEFERRED, run over a full-screen triangle
+    m_deferredVariants = std::make_unique<ShaderVariantCache>("./deferred.vert", "./minecraft.frag",
+        [this](ShaderProgram& program) { setupMainProgram(program); });
+
+    // The depth programs only vary with the registry, which is fixed for the run
+    std::string depthDefines = ShaderDefines().set("CUTOUT", m_hasCutoutLayers ? 1 : 0).toSource();
 
     m_depthShader = std::make_unique<ShaderProgram>();
-    m_depthShader->loadShaders("./shadow_dir.vert", "./shadow_dir.frag");
+    m_depthShader->loadShaders("./shadow_dir.vert", "./shadow_dir.frag", depthDefines);
+
+    m_prepassShader = std::make_unique<ShaderProgram>();
+    m_prepassShader->loadShaders("./depth_prepass.vert", "./depth_prepass.frag", depthDefines);
+    m_prepassShader->bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+
+    m_gBufferShader = std::make_unique<ShaderProgram>();
+    m_gBufferShader->loadShaders("./minecraft.vert", "./gbuffer.frag", depthDefines);
+    m_gBufferShader->bindUniformBlock("FrameData", FRAME_DATA_BINDING);
 
     m_pointDepthShader = std::make_unique<ShaderProgram>();
-    m_pointDepthShader->loadShaders("./shadow_dir.vert", "./depth_point.frag");
+    m_pointDepthShader->loadShaders("./shadow_point.vert", "./shadow_point.geom", "./depth_point.frag", depthDefines);
 
     m_crosshairShader = std::make_unique<ShaderProgram>();
     m_crosshairShader->loadShaders("./crosshair.vert", "./crosshair.frag");
 
     m_guiShader = std::make_unique<ShaderProgram>();
     m_guiShader->loadShaders("./gui.vert", "./gui.frag");
+
+    // The GUI samples either a plain texture (unit 0) or a block texture layer (unit 1)
+    m_guiShader->use();
+    m_guiShader->setUniformSampler("guiTexture", 0);
+    m_guiShader->setUniformSampler("guiTextureArray", 1);
+    m_guiShader->setUniform("guiLayer", -1);
+
+    m_depthModel = m_depthShader->getUniform<glm::mat4>("model");
+    m_depthLightSpaceMatrix = m_depthShader->getUniform<glm::mat4>("lightSpaceMatrix");
+    m_prepassModel = m_prepassShader->getUniform<glm::mat4>("model");
+    m_prepassUseModelTexture = m_prepassShader->getUniform<GLint>("useModelTexture");
+    m_gBufferModel = m_gBufferShader->getUniform<glm::mat4>("model");
+    m_gBufferUseModelTexture = m_gBufferShader->getUniform<GLint>("useModelTexture");
+    m_pointDepthModel = m_pointDepthShader->getUniform<glm::mat4>("model");
+    for (int face = 0; face < 6; face++) {
+        m_pointDepthFaceMatrices[face] = m_pointDepthShader->getUniform<glm::mat4>(("faceMatrices[" + std::to_string(face) + "]").c_str());
+    }
+    for (int face = 0; face < 6; face++) {
+        m_pointDepthFaceTiles[face] = m_pointDepthShader->getUniform<glm::vec4>(("faceTiles[" + std::to_string(face) + "]").c_str());
+    }
+    m_pointDepthFaceMask = m_pointDepthShader->getUniform<GLint>("faceMask");
+    m_guiModel = m_guiShader->getUniform<glm::mat4>("model");
+    m_guiLayer = m_guiShader->getUniform<GLint>("guiLayer");
+    m_guiTintColor = m_guiShader->getUniform<glm::vec3>("tintColor");
+
+    if (m_depthShader->hasUniform("blockTextures")) {
+        m_depthShader->use();
+        m_depthShader->setUniformSampler("blockTextures", BLOCK_TEXTURE_UNIT);
+    }
+    if (m_prepassShader->hasUniform("blockTextures")) {
+        m_prepassShader->use();
+        m_prepassShader->setUniformSampler("blockTextures", BLOCK_TEXTURE_UNIT);
+        m_prepassShader->setUniformSampler("modelTexture", MODEL_TEXTURE_UNIT);
+    }
+    m_gBufferShader->use();
+    m_gBufferShader->setUniformSampler("blockTextures", BLOCK_TEXTURE_UNIT);
+    m_gBufferShader->setUniformSampler("modelTexture", MODEL_TEXTURE_UNIT);
+
+    // Full-featured variant up front so the first frame does not stall on it
+    selectMainShader(MAX_POINT_LIGHTS, MAX_SPOT_LIGHTS);
+
+    // Model meshes have no baked light attribute: no block light, full sky light
+    glVertexAttribI4ui(3, Chunk::packVertexLight(0, Chunk::MAX_LIGHT_LEVEL), 0, 0, 0);
+
+    // Cutout and shadow-casting flags are read from the material table
+    m_depthShader->bindUniformBlock("BlockMaterials", BLOCK_MATERIALS_BINDING);
+    m_pointDepthShader->bindUniformBlock("BlockMaterials", BLOCK_MATERIALS_BINDING);
 }
 
-void Renderer::initShadows() {
-    // Directional Shadow Map
-    glGenFramebuffers(1, &m_dirShadowMapFBO);
-    glGenTextures(1, &m_dirShadowMap);
-    glBindTexture(GL_TEXTURE_2D, m_dirShadowMap);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, DIR_SHADOW_WIDTH, DIR_SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+void Renderer::initUniformBuffers() {
+    m_blockMaterialUBO.create(sizeof(BlockMaterialStd140) * MAX_BLOCK_TEXTURES, BLOCK_MATERIALS_BINDING);
+    m_frameDataUBO.create(sizeof(FrameDataStd140), FRAME_DATA_BINDING);
+    m_lightsUBO.create(sizeof(LightsStd140), LIGHTS_BINDING);
+
+    m_pointLightDataTBO.create(GL_RGBA32F);
+    m_clusterGridTBO.create(GL_RG32UI);
+    m_clusterLightIndexTBO.create(GL_R32UI);
+}
+
+void Renderer::initQueries() {
+    // Invocations are what the pre-pass saves; samples passed is the core fallback, and the same
+    // number as long as early depth testing rejects hidden fragments before shading
+    if (GLEW_ARB_pipeline_statistics_query) {
+        m_fragmentQueryTarget = GL_FRAGMENT_SHADER_INVOCATIONS_ARB;
+    }
+    glGenQueries(FRAGMENT_QUERY_FRAMES, m_fragmentQueries);
+}
+
+void Renderer::setupMainProgram(ShaderProgram& program) {
+    program.bindUniformBlock("BlockMaterials", BLOCK_MATERIALS_BINDING);
+    program.bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+    program.bindUniformBlock("Lights", LIGHTS_BINDING);
+
+    // Shadow maps always sit on the same units, only the bound textures change
+    program.use();
+    if (program.hasUniform("gDepth")) {
+        // Deferred variants read their surfaces from the G-buffer instead
+        program.setUniformSampler("gAlbedo", FIRST_GBUFFER_UNIT);
+        program.setUniformSampler("gNormal", FIRST_GBUFFER_UNIT + 1);
+        program.setUniformSampler("gLighting", FIRST_GBUFFER_UNIT + 2);
+        program.setUniformSampler("gDepth", FIRST_GBUFFER_UNIT + 3);
+    } else {
+        program.setUniformSampler("blockTextures", BLOCK_TEXTURE_UNIT);
+        program.setUniformSampler("modelTexture", MODEL_TEXTURE_UNIT);
+    }
+    if (program.hasUniform("clusterGrid")) {
+        program.setUniformSampler("pointLightData", POINT_LIGHT_DATA_UNIT);
+        program.setUniformSampler("clusterGrid", CLUSTER_GRID_UNIT);
+        program.setUniformSampler("clusterLightIndices", CLUSTER_LIGHT_INDEX_UNIT);
+    }
+    if (program.hasUniform("dirShadowMaps")) {
+        int textureUnit = FIRST_SHADOW_TEXTURE_UNIT;
+        program.setUniformSampler("dirShadowMaps", textureUnit++);
+        program.setUniformSampler("shadowAtlas", textureUnit++);
+    }
+}
+
+void Renderer::selectMainShader(int pointLightCount, int spotLightCount) {
+    MainVariantKey key;
+    key.pointLights = pointLightCount > 0;
+    key.spotLightBucket = lightBucket(spotLightCount, MAX_SPOT_LIGHTS);
+    key.shadows = m_shadowsEnabled;
+    key.cutout = m_hasCutoutLayers;
+    key.pcfRadius = m_pcfRadius;
+    key.bakedBlockLight = !m_dynamicBlockLights;
+    key.deferred = m_deferredShading;
+
+    if (m_minecraftShader && key == m_mainVariant) return;
+
+    ShaderDefines defines;
+    defines.set("POINT_LIGHTS", key.pointLights ? 1 : 0)
+           .set("SPOT_LIGHT_BUCKET", key.spotLightBucket)
+           .set("SHADOWS", key.shadows ? 1 : 0)
+           .set("CUTOUT", key.cutout ? 1 : 0)
+           .set("PCF_RADIUS", key.pcfRadius)
+           .set("BAKED_BLOCK_LIGHT", key.bakedBlockLight ? 1 : 0)
+           .set("DEFERRED", key.deferred ? 1 : 0);
+
+    m_minecraftShader = key.deferred ? &m_deferredVariants->get(defines) : &m_minecraftVariants->get(defines);
+    m_mainVariant = key;
+
+    if (key.deferred) {
+        m_mainModel = ShaderProgram::Uniform<glm::mat4>();
+        m_mainUseModelTexture = ShaderProgram::Uniform<GLint>();
+        m_mainClipToWorld = m_minecraftShader->getUniform<glm::mat4>("clipToWorld");
+    } else {
+        m_mainModel = m_minecraftShader->getUniform<glm::mat4>("model");
+        m_mainUseModelTexture = m_minecraftShader->getUniform<GLint>("useModelTexture");
+        m_mainClipToWorld = ShaderProgram::Uniform<glm::mat4>();
+    }
+}
+
+void Renderer::resizeGBuffer(int width, int height) {
+    if (width == m_gBufferWidth && height == m_gBufferHeight) return;
+    m_gBufferWidth = width;
+    m_gBufferHeight = height;
+
+    // Created on first use, so the forward path never pays for it
+    if (!m_gBufferFBO) {
+        glGenFramebuffers(1, &m_gBufferFBO);
+        glGenTextures(GBUFFER_TARGETS, m_gBufferTextures);
+        glGenTextures(1, &m_gBufferDepth);
+        glGenVertexArrays(1, &m_fullscreenVAO);
+    }
+
+    // Albedo and AO, normal, then block light, sky light and material layer
+    const GLenum internalFormats[GBUFFER_TARGETS] = { GL_RGBA8, GL_RGB10_A2, GL_RGBA8 };
+    for (int i = 0; i < GBUFFER_TARGETS; i++) {
+        GLState::bindTexture(GL_TEXTURE_2D, m_gBufferTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    // Same format as the default depth buffer, so it can be blitted there for the later passes
+    GLState::bindTexture(GL_TEXTURE_2D, m_gBufferDepth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+    GLState::bindFramebuffer(m_gBufferFBO);
+    const GLenum drawBuffers[GBUFFER_TARGETS] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    for (int i = 0; i < GBUFFER_TARGETS; i++) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, drawBuffers[i], GL_TEXTURE_2D, m_gBufferTextures[i], 0);
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_gBufferDepth, 0);
+    glDrawBuffers(GBUFFER_TARGETS, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        throw std::runtime_error("G-buffer Framebuffer not complete!");
+    }
+    GLState::bindFramebuffer(0);
+}
+
+void Renderer::uploadFrameData(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos) {
+    FrameDataStd140 frame = {};
+    frame.view = view;
+    frame.projection = projection;
+    frame.viewPos = viewPos;
+
+    m_frameDataUBO.update(&frame, sizeof(frame));
+}
+
+void Renderer::uploadLights(const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights) {
+    LightsStd140 lights = {};
+    lights.dirLight.direction = m_dirLight.direction;
+    lights.dirLight.ambient = m_dirLight.ambient;
+    lights.dirLight.diffuse = m_dirLight.diffuse;
+    lights.dirLight.specular = m_dirLight.specular;
+
+    lights.numPointLights = (int)pointLights.size();
+    lights.clusterParams = m_lightClusters.getClusterParams();
+
+    lights.numSpotLights = (int)glm::min(spotLights.size(), (size_t)MAX_SPOT_LIGHTS);
+    for (int i = 0; i < lights.numSpotLights; i++) {
+        const SpotLight& src = spotLights[i];
+        SpotLightStd140& dst = lights.spotLights[i];
+        dst.position = src.position;
+        dst.direction = src.direction;
+        dst.ambient = src.ambient;
+        dst.diffuse = src.diffuse;
+        dst.specular = src.specular;
+        dst.constant = src.constant;
+        dst.linear = src.linear;
+        dst.exponant = src.exponant;
+        dst.cosInnerCone = src.cosInnerCone;
+        dst.cosOuterCone = src.cosOuterCone;
+        if (i < (int)m_spotLightSpaceMatrices.size()) {
+            lights.spotLightSpaceMatrices[i] = m_spotLightSpaceMatrices[i]; // Not computed while shadows are off
+        }
+    }
+
+    lights.pointFarPlane = POINT_FAR_PLANE;
+
+    for (int i = 0; i < DIR_SHADOW_CASCADES; i++) {
+        lights.dirLightSpaceMatrices[i] = m_dirCascades[i].lightSpace;
+        lights.cascadeSplits[i] = m_dirCascades[i].splitFar;
+        lights.cascadeDepthBias[i] = m_dirCascades[i].depthBias;
+    }
+    // Tiles as packed for this frame; a dropped light gets an empty tile and no shadow
+    if (m_shadowsEnabled) {
+        lights.numPointShadows = m_pointShadowCount;
+        for (int i = 0; i < m_pointShadowCount; i++) {
+            for (int face = 0; face < 6; face++) {
+                lights.pointShadowTiles[i * 6 + face] = m_shadowAtlas.getTileRect(i, face);
+            }
+        }
+        for (int i = 0; i < m_spotShadowCount; i++) {
+            lights.spotShadowTiles[i] = m_shadowAtlas.getTileRect(m_pointShadowCount + i, 0);
+        }
+    }
+
+    // Only the used part of the arrays changes, but one upload of ~1.4 KB is cheaper than tracking it
+    m_lightsUBO.update(&lights, sizeof(lights));
+}
+
+void Renderer::uploadBlockMaterials() {
+    BlockMaterialStd140 materials[MAX_BLOCK_TEXTURES] = {};
+    const int layerCount = glm::min(BlockRegistry::getLayerCount(), MAX_BLOCK_TEXTURES);
+    for (int layer = 0; layer < layerCount; layer++) {
+        const BlockMaterial& mat = BlockRegistry::getLayerMaterial(layer);
+        materials[layer].ambient = mat.ambient;
+        materials[layer].flags = BlockRegistry::getLayerFlags(layer);
+        materials[layer].specular = mat.specular;
+        materials[layer].shininess = mat.shininess;
+    }
+
+    m_blockMaterialUBO.update(materials, sizeof(materials));
+    m_blockMaterialVersion = BlockRegistry::getMaterialVersion();
+}
+
+void Renderer::initShadows() {
+    // Directional Shadow Maps: one array layer per cascade
+    glGenFramebuffers(1, &m_dirShadowMapFBO);
+    glGenTextures(1, &m_dirShadowMaps);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, m_dirShadowMaps);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, DIR_SHADOW_WIDTH, DIR_SHADOW_HEIGHT, DIR_SHADOW_CASCADES, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
     float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_dirShadowMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_dirShadowMap, 0);
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+    GLState::bindFramebuffer(m_dirShadowMapFBO);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_dirShadowMaps, 0, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         throw std::runtime_error("Dir Shadow Framebuffer not complete!");
     }
 
-    // Point Light Shadow Map (Cube Map)
-    glGenFramebuffers(1, &m_pointShadowMapFBO);
-    glGenTextures(1, &m_pointShadowMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_pointShadowMap);
-    for (unsigned int i = 0; i < 6; ++i) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, POINT_SHADOW_WIDTH, POINT_SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_pointShadowMapFBO);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_pointShadowMap, 0);
+    // Point and spot light shadow atlas: every local light draws into its own tiles
+    glGenFramebuffers(1, &m_shadowAtlasFBO);
+    glGenTextures(1, &m_shadowAtlasTexture);
+    GLState::bindTexture(GL_TEXTURE_2D, m_shadowAtlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GLState::bindFramebuffer(m_shadowAtlasFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_shadowAtlasTexture, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        throw std::runtime_error("Point Shadow Framebuffer not complete!");
+        throw std::runtime_error("Shadow Atlas Framebuffer not complete!");
     }
 
-    // Spot Light Shadow Maps
-    m_spotShadowMapFBOs.resize(MAX_SPOT_LIGHTS);
-    m_spotShadowMaps.resize(MAX_SPOT_LIGHTS);
-    glGenFramebuffers(MAX_SPOT_LIGHTS, m_spotShadowMapFBOs.data());
-    glGenTextures(MAX_SPOT_LIGHTS, m_spotShadowMaps.data());
-    for (int i = 0; i < MAX_SPOT_LIGHTS; ++i) {
-        glBindTexture(GL_TEXTURE_2D, m_spotShadowMaps[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SPOT_SHADOW_WIDTH, SPOT_SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-    }
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::bindFramebuffer(0);
 }
 
 void Renderer::initCrosshair() {
     glGenVertexArrays(1, &m_crosshairVAO);
     glGenBuffers(1, &m_crosshairVBO);
-    glBindVertexArray(m_crosshairVAO);
+    GLState::bindVertexArray(m_crosshairVAO);
     glBindBuffer(GL_ARRAY_BUFFER, m_crosshairVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 24, nullptr, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
     glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 void Renderer::render(const FPSCamera& camera, const World& world, const Scene& scene,
                       const std::map<std::string, std::unique_ptr<Mesh>>& meshCache,
                       const std::map<std::string, std::unique_ptr<Texture2D>>& modelTextureCache,
-                      const Texture2D* blockTextures,
+                      const TextureArray* blockTextures,
                       int windowWidth, int windowHeight) {
+    // Minimised: nothing to draw into, and the G-buffer keeps its last size
+    if (windowWidth <= 0 || windowHeight <= 0) return;
+
+    // 0. Occlusion culling runs on its worker while the lights and shadow maps are prepared; the
+    // main pass collects it. Nothing edits the world until render() returns.
+    if (m_occlusionCulling) {
+        float aspectRatio = (float)windowWidth / (float)windowHeight;
+        glm::mat4 projection = glm::perspective(glm::radians(camera.getFOV()), aspectRatio, MAIN_NEAR_PLANE, MAIN_FAR_PLANE);
+        m_occlusionCuller.begin(world, projection * camera.getViewMatrix(), camera.getPosition());
+    }
 
     // 1. Collect all lights for the frame
     std::vector<PointLight> pointLights;
     std::vector<SpotLight> spotLights;
 
-    for (const auto& pos : world.getRedstoneLightPositions()) {
-        if (pointLights.size() >= MAX_POINT_LIGHTS) break;
-        pointLights.push_back(CreateRedstoneLight(pos));
-    }
-    for (const auto& pos : world.getTorchLightPositions()) {
-        if (pointLights.size() >= MAX_POINT_LIGHTS) break;
-        pointLights.push_back(CreateTorchLight(pos));
+    // The most relevant emitters come first, so they are the ones that get point shadows
+    m_lightSelectionStats = LightIndex::QueryStats();
+    if (m_dynamicBlockLights) {
+        world.selectBlockLights(camera.getPosition(), MAX_SELECTED_EMITTERS, m_selectedLights, m_lightSelectionStats);
+        m_lightAggregator.aggregate(m_selectedLights, camera.getPosition(), pointLights);
+        m_selectedLights.clear();
+        if (pointLights.size() > (size_t)MAX_POINT_LIGHTS) pointLights.resize(MAX_POINT_LIGHTS);
     }
     for (const auto& modelData : scene.models) { // No change needed here, range-based for loop works on both
         if (spotLights.size() >= MAX_SPOT_LIGHTS) break;
@@ -152,19 +630,36 @@ void Renderer::render(const FPSCamera& camera, const World& world, const Scene&
         glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(modelData.rotation.angle), modelData.rotation.axis);
         glm::vec3 lookDirection = glm::normalize(glm::vec3(rotationMatrix * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f)));
 
-        glm::vec3 eyeOffset1 = glm::vec3(rotationMatrix * glm::vec4(0.1f, 2.75f, 0.4f, 1.0f));
-        glm::vec3 eyeLightPos1 = modelData.position + eyeOffset1;
-        spotLights.push_back(CreateEndermanLight(eyeLightPos1, lookDirection));
-        if (spotLights.size() >= MAX_SPOT_LIGHTS) break;
-        glm::vec3 eyeOffset2 = glm::vec3(rotationMatrix * glm::vec4(-0.1f, 2.75f, 0.45f, 1.0f));
-        glm::vec3 eyeLightPos2 = modelData.position + eyeOffset2;
-        spotLights.push_back(CreateEndermanLight(eyeLightPos2, lookDirection));
+        // Both eyes share a direction and sit 0.2 apart: one spot light between them with their
+        // summed colour looks the same and needs one shadow map instead of two
+        glm::vec3 eyeOffset = glm::vec3(rotationMatrix * glm::vec4(0.0f, 2.75f, 0.425f, 1.0f));
+        SpotLight eyes = CreateEndermanLight(modelData.position + eyeOffset, lookDirection);
+        eyes.ambient *= 2.0f;
+        eyes.diffuse *= 2.0f;
+        eyes.specular *= 2.0f;
+        spotLights.push_back(eyes);
     }
 
-    // 2. Render Shadow Maps
-    dirShadowPass(camera, world, scene, meshCache, blockTextures);
-    pointShadowPass(pointLights, world, scene, meshCache);
-    spotShadowPass(spotLights, world, scene, meshCache);
+    // Material table lives in a uniform buffer and only changes with the block registry. The shadow
+    // passes read its layer flags, so it is refreshed before them.
+    if (m_blockMaterialVersion != BlockRegistry::getMaterialVersion()) {
+        uploadBlockMaterials();
+    }
+
+    // 2. Render Shadow Maps, only those the scheduler picked
+    m_shadowMapUpdates = 0;
+    m_frameIndex++;
+    updateModelShadowBounds(scene, meshCache);
+    if (m_shadowsEnabled) {
+        dirShadowPass(camera, (float)windowWidth / (float)windowHeight, world, scene, meshCache, blockTextures);
+
+        // Local lights share the atlas, re-packed every frame from their current importance
+        packShadowAtlas(camera, pointLights, spotLights);
+        scheduleShadowUpdates(pointLights, spotLights);
+        pointShadowPass(pointLights, world, scene, meshCache);
+        spotShadowPass(spotLights, world, scene, meshCache);
+        m_shadowCache.swap(m_nextShadowCache);
+    }
 
     // 3. Main Render Pass
     mainRenderPass(camera, world, scene, meshCache, modelTextureCache, blockTextures, pointLights, spotLights, windowWidth, windowHeight);
@@ -185,135 +680,380 @@ void Renderer::updateSun(float deltaTime) {
     m_dirLight.direction = glm::normalize(m_dirLight.direction);
 }
 
-void Renderer::renderScene(ShaderProgram& shader, const World& world, const Scene& scene,
-                           const std::map<std::string, std::unique_ptr<Mesh>>& meshCache) {
-    glm::mat4 model(1.0f);
-    shader.setUniform("model", model);
-    world.draw();
-
-    for (const auto& modelData : scene.models) { // No change needed here
-        if (meshCache.count(modelData.meshFile)) {
-            Mesh* mesh = meshCache.at(modelData.meshFile).get();
-            glm::mat4 modelMatrix = glm::mat4(1.0f);
-            modelMatrix = glm::translate(modelMatrix, modelData.position);
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(modelData.rotation.angle), modelData.rotation.axis);
-            modelMatrix = glm::scale(modelMatrix, modelData.scale);
-            shader.setUniform("model", modelMatrix);
-            mesh->draw();
+void Renderer::invalidateShadows(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    // Light volumes are bounded by spheres of the shadow far plane, conservative for spot cones.
+    // Stale tiles stay usable until the scheduler gets to them.
+    for (CachedShadow& cached : m_shadowCache) {
+        float range = cached.point ? POINT_FAR_PLANE : SPOT_FAR_PLANE;
+        if (cached.valid && sphereIntersectsBox(cached.position, range, boxMin, boxMax)) {
+            cached.dirty = true;
+        }
+    }
+
+    // A sun cascade sees exactly its light space box
+    for (DirCascade& cascade : m_dirCascades) {
+        if (cascade.valid && !boxOutsideClipVolume(cascade.lightSpace, boxMin, boxMax)) {
+            cascade.valid = false;
         }
     }
 }
 
-void Renderer::dirShadowPass(const FPSCamera& camera, const World& world, const Scene& scene,
-                             const std::map<std::string, std::unique_ptr<Mesh>>& meshCache, const Texture2D* blockTextures) {
-float dir_near_plane = 1.0f, dir_far_plane = 70.0f;
-    // Orthographic bounds are [-40, 40], so total frustum size is 80 units.
-    glm::mat4 dirLightProjection = glm::ortho(-40.0f, 40.0f, -40.0f, 40.0f, dir_near_plane, dir_far_plane);
-    glm::vec3 centerPos = camera.getPosition();
+void Renderer::onModelChanged(size_t modelIndex) {
+    m_changedModels.push_back(modelIndex);
+}
 
-    // 1. Initial Light View matrix
-    glm::vec3 lightTarget = centerPos;
-    glm::vec3 lightPos = lightTarget - m_dirLight.direction * 20.0f;
-    glm::mat4 dirLightView = glm::lookAt(lightPos, lightTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+void Renderer::updateModelShadowBounds(const Scene& scene, const std::map<std::string, std::unique_ptr<Mesh>>& meshCache) {
+    m_modelShadowBounds.resize(scene.models.size());
 
-    // 2. Snapping Logic for Voxel Alignment (Fixes diagonal/misaligned shadows)
-    glm::mat4 lightSpace = dirLightProjection * dirLightView;
-    glm::vec4 shadowOrigin = lightSpace * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    // A moved model invalidates the shadows that saw it where it was, and those that see it now
+    for (size_t index : m_changedModels) {
+        if (index >= m_modelShadowBounds.size()) continue;
+        Bounds& bounds = m_modelShadowBounds[index];
+        if (bounds.known) {
+            invalidateShadows(bounds.min, bounds.max);
+        }
+        bounds.known = modelWorldBounds(scene.models[index], meshCache, bounds.min, bounds.max);
+        if (bounds.known) {
+            invalidateShadows(bounds.min, bounds.max);
+        }
+    }
+    m_changedModels.clear();
 
-    // Scale factor: Frustum size (80.0f) / Resolution (2048) -> inverted for texel size
-    float worldToTexel = (float)DIR_SHADOW_WIDTH / 80.0f;
-    shadowOrigin *= worldToTexel;
+    for (size_t index = 0; index < scene.models.size(); index++) {
+        Bounds& bounds = m_modelShadowBounds[index];
+        if (!bounds.known) {
+            bounds.known = modelWorldBounds(scene.models[index], meshCache, bounds.min, bounds.max);
+        }
+    }
+}
 
-    // Snap the light-view coordinates to the nearest pixel center (floor)
-    shadowOrigin.x = floor(shadowOrigin.x);
-    shadowOrigin.y = floor(shadowOrigin.y);
+void Renderer::recordScene(RenderQueue& queue, ShaderProgram& shader, ShaderProgram::Uniform<glm::mat4> modelUniform,
+                           ShaderProgram::Uniform<GLint> materialUniform, const glm::vec3& eye, float maxDepth,
+                           const World& world, const Scene& scene, const std::map<std::string, std::unique_ptr<Mesh>>& meshCache,
+                           const std::map<std::string, std::unique_ptr<Texture2D>>* modelTextureCache,
+                           const glm::mat4* cullMatrix, const SectionVisibility* visibility,
+                           const OcclusionCuller* occlusion) {
+    queue.begin(eye, maxDepth);
+
+    // Chunk sections: world-space vertices, block textures come from the pass
+    const std::vector<Chunk*>& chunks = world.getChunks();
+    for (int chunkIndex = 0; chunkIndex < (int)chunks.size(); chunkIndex++) {
+        const Chunk* chunk = chunks[chunkIndex];
+        for (int section = 0; section < Chunk::SECTION_COUNT; section++) {
+            if (visibility && !visibility->isVisible(chunkIndex, section)) continue;
+            if (occlusion && occlusion->isOccluded(chunkIndex, section)) continue;
+            glm::vec3 center = chunk->getSectionCenter(section);
+            if (cullMatrix && boxOutsideClipVolume(*cullMatrix, center - SECTION_HALF_EXTENT, center + SECTION_HALF_EXTENT)) continue;
+
+            DrawCommand cmd;
+            cmd.program = &shader;
+            cmd.modelUniform = modelUniform;
+            cmd.materialUniform = materialUniform;
+            cmd.material = 0;
+            cmd.vao = chunk->getSectionVAO(section);
+            cmd.count = chunk->getSectionVertexCount(section);
+            queue.submit(cmd, center);
+        }
+    }
 
-    // Transform back to world space
-    glm::mat4 inverseLightSpace = glm::inverse(lightSpace);
-    glm::vec4 snappedOrigin = inverseLightSpace * (shadowOrigin / worldToTexel);
+    for (const auto& modelData : scene.models) {
+        auto meshIt = meshCache.find(modelData.meshFile);
+        if (meshIt == meshCache.end()) continue;
+        const Mesh* mesh = meshIt->second.get();
+
+        DrawCommand cmd;
+        cmd.program = &shader;
+        cmd.modelUniform = modelUniform;
+        cmd.model = modelMatrix(modelData);
+        // Models sample their own texture rather than a block layer
+        cmd.materialUniform = materialUniform;
+        cmd.material = 1;
+        cmd.vao = mesh->getVAO();
+        cmd.count = mesh->getVertexCount();
+
+        if (modelTextureCache) {
+            auto texIt = modelTextureCache->find(modelData.textureFile);
+            if (texIt != modelTextureCache->end()) {
+                cmd.texture = texIt->second->getTexture();
+                cmd.textureTarget = GL_TEXTURE_2D;
+                cmd.textureUnit = MODEL_TEXTURE_UNIT;
+            }
+        }
 
-    // Calculate the translation correction and apply it to the light's position/target
-    glm::vec3 translation = glm::vec3(snappedOrigin) - lightTarget;
-    lightTarget += translation;
-    lightPos += translation;
+        queue.submit(cmd, modelData.position);
+    }
 
-    // 3. Recalculate Light View and final Light Space Matrix with snapped position
-    dirLightView = glm::lookAt(lightPos, lightTarget, glm::vec3(0.0f, 1.0f, 0.0f));
-    m_dirLightSpaceMatrix = dirLightProjection * dirLightView;
+    queue.sort();
+}
 
-    glViewport(0, 0, DIR_SHADOW_WIDTH, DIR_SHADOW_HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_dirShadowMapFBO);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    // glCullFace(GL_FRONT);
-    glEnable(GL_POLYGON_OFFSET_FILL);
-    glPolygonOffset(4.0f, 100.0f);
+void Renderer::dirShadowPass(const FPSCamera& camera, float aspectRatio, const World& world, const Scene& scene,
+                             const std::map<std::string, std::unique_ptr<Mesh>>& meshCache, const TextureArray* blockTextures) {
+    glm::mat4 view = camera.getViewMatrix();
+    float fovY = glm::radians(camera.getFOV());
+
+    // Light space basis; the up hint changes near the zenith so it never lines up with the sun
+    glm::vec3 forward = glm::normalize(m_dirLight.direction);
+    glm::vec3 upHint = glm::abs(forward.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec3 right = glm::normalize(glm::cross(forward, upHint));
+    glm::vec3 up = glm::cross(right, forward);
+
+    bool targetBound = false;
+    float splitNear = MAIN_NEAR_PLANE;
+    for (int i = 0; i < DIR_SHADOW_CASCADES; ++i) {
+        DirCascade& cascade = m_dirCascades[i];
+        float splitFar = cascadeSplit(i);
+        cascade.splitFar = splitFar;
+
+        // Bounding sphere of the frustum slice. Its radius does not change as the camera turns,
+        // so neither does the texel size; rounding it up absorbs float noise.
+        glm::mat4 sliceToWorld = glm::inverse(glm::perspective(fovY, aspectRatio, splitNear, splitFar) * view);
+        splitNear = splitFar;
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec4 ndc((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f, 1.0f);
+            glm::vec4 world4 = sliceToWorld * ndc;
+            corners[corner] = glm::vec3(world4) / world4.w;
+            center += corners[corner] / 8.0f;
+        }
+        float radius = 0.0f;
+        for (const glm::vec3& corner : corners) {
+            radius = glm::max(radius, glm::length(corner - center));
+        }
+        radius = std::ceil(radius);
+
+        // Snap the centre to whole texels in light space: the map slides in texel steps, so
+        // shadow edges do not shimmer as the camera moves (same idea as the single map had)
+        float texelSize = 2.0f * radius / DIR_SHADOW_WIDTH;
+        glm::ivec3 snapped((int)std::floor(glm::dot(center, right) / texelSize),
+                           (int)std::floor(glm::dot(center, up) / texelSize),
+                           (int)std::floor(glm::dot(center, forward) / texelSize));
+
+        float sunTurn = glm::acos(glm::clamp(glm::dot(forward, cascade.direction), -1.0f, 1.0f));
+        if (cascade.valid && snapped == cascade.snappedCenter && radius == cascade.radius && sunTurn < SUN_UPDATE_ANGLE) {
+            continue; // Keep the previous map and its light space matrix
+        }
+        cascade.valid = true;
+        cascade.snappedCenter = snapped;
+        cascade.radius = radius;
+        cascade.direction = forward;
+
+        glm::vec3 snappedCenter = (right * (float)snapped.x + up * (float)snapped.y + forward * (float)snapped.z) * texelSize;
+        float depthRange = 2.0f * radius + DIR_SHADOW_CASTER_MARGIN;
+        glm::vec3 lightPos = snappedCenter - forward * (radius + DIR_SHADOW_CASTER_MARGIN);
+        cascade.lightSpace = glm::ortho(-radius, radius, -radius, radius, 0.0f, depthRange) * glm::lookAt(lightPos, snappedCenter, up);
+        cascade.depthBias = DIR_SHADOW_BIAS_TEXELS * texelSize / depthRange;
+
+        if (!targetBound) {
+            GLState::viewport(0, 0, DIR_SHADOW_WIDTH, DIR_SHADOW_HEIGHT);
+            GLState::bindFramebuffer(m_dirShadowMapFBO);
+            GLState::enable(GL_POLYGON_OFFSET_FILL);
+            glPolygonOffset(4.0f, 100.0f);
+            m_depthShader->use();
+            blockTextures->bind(BLOCK_TEXTURE_UNIT);
+            targetBound = true;
+        }
 
-    m_depthShader->use();
-    m_depthShader->setUniform("lightSpaceMatrix", m_dirLightSpaceMatrix);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_dirShadowMaps, 0, i);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        m_depthShader->setUniform(m_depthLightSpaceMatrix, cascade.lightSpace);
 
-    const auto& pathToIndex = Chunk::m_pathToTextureIndex;
-    for (size_t i = 0; i < pathToIndex.size(); i++) {
-        blockTextures[i].bind(i);
-        m_depthShader->setUniformSampler(("diffuseMaps[" + std::to_string(i) + "]").c_str(), i);
+        // Only the sections inside this cascade's box
+        recordScene(m_shadowQueue, *m_depthShader, m_depthModel, ShaderProgram::Uniform<GLint>(), lightPos, depthRange,
+                    world, scene, meshCache, nullptr, &cascade.lightSpace);
+        m_shadowQueue.execute();
+        m_shadowMapUpdates++;
     }
 
-    renderScene(*m_depthShader, world, scene, meshCache);
+    if (targetBound) {
+        GLState::disable(GL_POLYGON_OFFSET_FILL);
+        GLState::cullFace(GL_BACK);
+        GLState::bindFramebuffer(0);
+    }
+}
 
-    for (size_t i = 0; i < pathToIndex.size(); i++) {
-        blockTextures[i].unbind(i);
+void Renderer::recordPointShadowCasters(const glm::vec3& lightPos, const World& world, const Scene& scene,
+                                        const std::map<std::string, std::unique_ptr<Mesh>>& meshCache) {
+    m_shadowQueue.begin(lightPos, POINT_FAR_PLANE);
+
+    // Each section only goes to the cube faces its bounds overlap, and not at all when out of range
+    for (const Chunk* chunk : world.getChunks()) {
+        for (int section = 0; section < Chunk::SECTION_COUNT; section++) {
+            glm::vec3 center = chunk->getSectionCenter(section);
+            int faceMask = cubeFaceMask(lightPos, center - SECTION_HALF_EXTENT, center + SECTION_HALF_EXTENT, POINT_FAR_PLANE);
+            if (faceMask == 0) continue;
+
+            DrawCommand cmd;
+            cmd.program = m_pointDepthShader.get();
+            cmd.modelUniform = m_pointDepthModel;
+            cmd.materialUniform = m_pointDepthFaceMask;
+            cmd.material = faceMask;
+            cmd.vao = chunk->getSectionVAO(section);
+            cmd.count = chunk->getSectionVertexCount(section);
+            m_shadowQueue.submit(cmd, center);
+        }
     }
 
-    // glCullFace(GL_BACK);
-    glDisable(GL_POLYGON_OFFSET_FILL);
-    glCullFace(GL_BACK);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Models are few and move: they go to every face and the geometry shader drops what misses
+    for (const auto& modelData : scene.models) {
+        auto meshIt = meshCache.find(modelData.meshFile);
+        if (meshIt == meshCache.end()) continue;
+        const Mesh* mesh = meshIt->second.get();
+
+        DrawCommand cmd;
+        cmd.program = m_pointDepthShader.get();
+        cmd.modelUniform = m_pointDepthModel;
+        cmd.model = modelMatrix(modelData);
+        cmd.materialUniform = m_pointDepthFaceMask;
+        cmd.material = ALL_CUBE_FACES;
+        cmd.vao = mesh->getVAO();
+        cmd.count = mesh->getVertexCount();
+        m_shadowQueue.submit(cmd, modelData.position);
+    }
+
+    m_shadowQueue.sort();
 }
 
-void Renderer::pointShadowPass(const std::vector<PointLight>& pointLights, const World& world, const Scene& scene,
-                               const std::map<std::string, std::unique_ptr<Mesh>>& meshCache) {
-    if (pointLights.empty()) return;
+void Renderer::packShadowAtlas(const FPSCamera& camera, const std::vector<PointLight>& pointLights,
+                               const std::vector<SpotLight>& spotLights) {
+    // Point lights first, then spot lights: request i is point light i, request m_pointShadowCount + i is spot light i
+    float fovY = glm::radians(camera.getFOV());
+    m_shadowAtlas.begin();
+    m_pointShadowCount = (int)glm::min(pointLights.size(), (size_t)MAX_POINT_SHADOWS);
+    for (int i = 0; i < m_pointShadowCount; ++i) {
+        float range = glm::min(LightClusterGrid::computeRange(pointLights[i]), POINT_FAR_PLANE);
+        m_shadowAtlas.request(projectedSize(pointLights[i].position, range, camera.getPosition(), fovY), 6);
+    }
+    m_spotShadowCount = (int)glm::min(spotLights.size(), (size_t)MAX_SPOT_LIGHTS);
+    for (int i = 0; i < m_spotShadowCount; ++i) {
+        m_shadowAtlas.request(projectedSize(spotLights[i].position, SPOT_FAR_PLANE, camera.getPosition(), fovY), 1);
+    }
+    m_shadowAtlas.pack();
+}
+
+const Renderer::CachedShadow* Renderer::findCachedShadow(const CachedShadow& wanted) const {
+    for (const CachedShadow& cached : m_shadowCache) {
+        if (cached.valid && cached.point == wanted.point && cached.tile == wanted.tile && cached.position == wanted.position
+            && cached.direction == wanted.direction && cached.cosOuterCone == wanted.cosOuterCone) {
+            return &cached;
+        }
+    }
+    return nullptr;
+}
+
+void Renderer::scheduleShadowUpdates(const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights) {
+    int requestCount = m_pointShadowCount + m_spotShadowCount;
+    m_shadowTileUpdates.assign(requestCount, false);
+    m_nextShadowCache.assign(requestCount, CachedShadow());
+    m_staleShadowRequests.clear();
+    long long budget = SHADOW_UPDATE_TEXEL_BUDGET;
+
+    // Tiles with nothing usable in them (new light, moved light, new tile) are drawn now
+    for (int request = 0; request < requestCount; ++request) {
+        if (m_shadowAtlas.getTileSize(request) == 0) continue;
+
+        CachedShadow& entry = m_nextShadowCache[request];
+        entry.valid = true;
+        entry.point = request < m_pointShadowCount;
+        if (entry.point) {
+            entry.position = pointLights[request].position;
+        } else {
+            const SpotLight& light = spotLights[request - m_pointShadowCount];
+            entry.position = light.position;
+            entry.direction = light.direction;
+            entry.cosOuterCone = light.cosOuterCone;
+        }
+        entry.tile = m_shadowAtlas.getTile(request, 0);
 
-    glm::mat4 pointShadowProj = glm::perspective(glm::radians(90.0f), (float)POINT_SHADOW_WIDTH / (float)POINT_SHADOW_HEIGHT, POINT_NEAR_PLANE, POINT_FAR_PLANE);
+        if (const CachedShadow* cached = findCachedShadow(entry)) {
+            entry.dirty = cached->dirty;
+            entry.waiting = cached->waiting;
+            if (entry.dirty) m_staleShadowRequests.push_back(request);
+        } else {
+            m_shadowTileUpdates[request] = true;
+            budget -= m_shadowAtlas.getTexels(request);
+        }
+    }
 
-    glViewport(0, 0, POINT_SHADOW_WIDTH, POINT_SHADOW_HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_pointShadowMapFBO);
+    // Stale tiles share what is left, weighted round-robin: waiting grows by importance every frame
+    // a tile stays stale, and the longest waiting go first. Far lights only compete every Nth frame.
+    for (int request : m_staleShadowRequests) {
+        m_nextShadowCache[request].waiting += m_shadowAtlas.getImportance(request);
+    }
+    std::stable_sort(m_staleShadowRequests.begin(), m_staleShadowRequests.end(), [this](int a, int b) {
+        return m_nextShadowCache[a].waiting > m_nextShadowCache[b].waiting;
+    });
+    bool farLightFrame = m_frameIndex % FAR_LIGHT_UPDATE_INTERVAL == 0;
+    for (int request : m_staleShadowRequests) {
+        if (budget <= 0) break;
+        if (m_shadowAtlas.getImportance(request) < FAR_LIGHT_IMPORTANCE && !farLightFrame) continue;
+
+        CachedShadow& entry = m_nextShadowCache[request];
+        entry.dirty = false;
+        entry.waiting = 0.0f;
+        m_shadowTileUpdates[request] = true;
+        budget -= m_shadowAtlas.getTexels(request);
+    }
+}
 
-    m_pointDepthShader->use();
-    m_pointDepthShader->setUniform("farPlane", POINT_FAR_PLANE);
+void Renderer::pointShadowPass(const std::vector<PointLight>& pointLights, const World& world, const Scene& scene,
+                               const std::map<std::string, std::unique_ptr<Mesh>>& meshCache) {
+    glm::mat4 pointShadowProj = glm::perspective(glm::radians(90.0f), 1.0f, POINT_NEAR_PLANE, POINT_FAR_PLANE);
+    bool targetBound = false;
+
+    for (int i = 0; i < m_pointShadowCount; ++i) {
+        if (!m_shadowTileUpdates[i]) continue;
+
+        if (!targetBound) {
+            GLState::bindFramebuffer(m_shadowAtlasFBO);
+            GLState::viewport(0, 0, SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE);
+            GLState::enable(GL_SCISSOR_TEST);
+            for (int plane = 0; plane < 4; ++plane) {
+                GLState::enable(GL_CLIP_DISTANCE0 + plane);
+            }
+            m_pointDepthShader->use();
+            m_pointDepthShader->setUniform("farPlane", POINT_FAR_PLANE);
+            targetBound = true;
+        }
 
-    // This demo renders shadows for only the first point light for performance.
-    // To render for all, you would need multiple cube map textures.
-    const auto& lightPos = pointLights[0].position;
-    m_pointDepthShader->setUniform("lightPos", lightPos);
+        const glm::vec3& lightPos = pointLights[i].position;
+        m_pointDepthShader->setUniform("lightPos", lightPos);
+        for (int face = 0; face < 6; ++face) {
+            const ShadowAtlas::Tile& tile = m_shadowAtlas.getTile(i, face);
+            clearAtlasTile(tile);
 
-    std::vector<glm::mat4> pointShadowTransforms;
-    pointShadowTransforms.push_back(pointShadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
-    pointShadowTransforms.push_back(pointShadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
-    pointShadowTransforms.push_back(pointShadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.0, 1.0)));
-    pointShadowTransforms.push_back(pointShadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0, -1.0, 0.0), glm::vec3(0.0, 0.0, -1.0)));
-    pointShadowTransforms.push_back(pointShadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0)));
-    pointShadowTransforms.push_back(pointShadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0, 0.0, -1.0), glm::vec3(0.0, -1.0, 0.0)));
+            glm::mat4 faceView = glm::lookAt(lightPos, lightPos + CUBE_FACE_DIRECTIONS[face], CUBE_FACE_UPS[face]);
+            m_pointDepthShader->setUniform(m_pointDepthFaceMatrices[face], pointShadowProj * faceView);
+            m_pointDepthShader->setUniform(m_pointDepthFaceTiles[face], atlasTileNDC(tile));
+        }
 
-    for (int j = 0; j < 6; ++j) {
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + j, m_pointShadowMap, 0);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        m_pointDepthShader->setUniform("lightSpaceMatrix", pointShadowTransforms[j]);
-        renderScene(*m_pointDepthShader, world, scene, meshCache);
+        // One pass over the casters fills all six faces: the geometry shader squeezes each face
+        // into its tile of the full-atlas viewport and clips it there
+        GLState::disable(GL_SCISSOR_TEST);
+        recordPointShadowCasters(lightPos, world, scene, meshCache);
+        m_shadowQueue.execute();
+        GLState::enable(GL_SCISSOR_TEST);
+
+        m_shadowMapUpdates++;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (targetBound) {
+        for (int plane = 0; plane < 4; ++plane) {
+            GLState::disable(GL_CLIP_DISTANCE0 + plane);
+        }
+        GLState::disable(GL_SCISSOR_TEST);
+        GLState::bindFramebuffer(0);
+    }
 }
 
 void Renderer::spotShadowPass(const std::vector<SpotLight>& spotLights, const World& world, const Scene& scene,
                               const std::map<std::string, std::unique_ptr<Mesh>>& meshCache) {
     if (spotLights.empty()) return;
 
-    glViewport(0, 0, SPOT_SHADOW_WIDTH, SPOT_SHADOW_HEIGHT);
-    m_depthShader->use();
-
     m_spotLightSpaceMatrices.resize(spotLights.size());
+    bool targetBound = false;
 
-    for (size_t i = 0; i < spotLights.size(); ++i) {
+    for (int i = 0; i < m_spotShadowCount; ++i) {
         const auto& light = spotLights[i];
         float fov = glm::acos(light.cosOuterCone) * 2.0f;
 
@@ -321,146 +1061,175 @@ void Renderer::spotShadowPass(const std::vector<SpotLight>& spotLights, const Wo
         glm::mat4 spotView = glm::lookAt(light.position, light.position + light.direction, glm::vec3(0.0f, 1.0f, 0.0f));
         m_spotLightSpaceMatrices[i] = spotProjection * spotView;
 
-        glBindFramebuffer(GL_FRAMEBUFFER, m_spotShadowMapFBOs[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_spotShadowMaps[i], 0);
-        glClear(GL_DEPTH_BUFFER_BIT);
+        int request = m_pointShadowCount + i;
+        if (!m_shadowTileUpdates[request]) continue;
+
+        if (!targetBound) {
+            GLState::bindFramebuffer(m_shadowAtlasFBO);
+            GLState::enable(GL_SCISSOR_TEST);
+            m_depthShader->use();
+            targetBound = true;
+        }
 
-        m_depthShader->setUniform("lightSpaceMatrix", m_spotLightSpaceMatrices[i]);
-        renderScene(*m_depthShader, world, scene, meshCache);
+        // The viewport maps the light's frustum onto its tile; the scissor keeps the clear there
+        const ShadowAtlas::Tile& tile = m_shadowAtlas.getTile(request, 0);
+        GLState::viewport(tile.x, tile.y, tile.size, tile.size);
+        clearAtlasTile(tile);
+
+        m_depthShader->setUniform(m_depthLightSpaceMatrix, m_spotLightSpaceMatrices[i]);
+        recordScene(m_shadowQueue, *m_depthShader, m_depthModel, ShaderProgram::Uniform<GLint>(), light.position, SPOT_FAR_PLANE,
+                    world, scene, meshCache, nullptr);
+        m_shadowQueue.execute();
+
+        m_shadowMapUpdates++;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (targetBound) {
+        GLState::disable(GL_SCISSOR_TEST);
+        GLState::bindFramebuffer(0);
+    }
 }
 
 void Renderer::mainRenderPass(const FPSCamera& camera, const World& world, const Scene& scene,
                               const std::map<std::string, std::unique_ptr<Mesh>>& meshCache,
                               const std::map<std::string, std::unique_ptr<Texture2D>>& modelTextureCache,
-                              const Texture2D* blockTextures,
+                              const TextureArray* blockTextures,
                               const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights,
                               int windowWidth, int windowHeight) {
 
-    glViewport(0, 0, windowWidth, windowHeight);
+    GLState::viewport(0, 0, windowWidth, windowHeight);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    // Cheapest variant that still covers this frame's lights
+    selectMainShader((int)pointLights.size(), (int)spotLights.size());
     m_minecraftShader->use();
 
-    // Camera and projection
+    // Camera, shadow matrices and lights: one buffer upload each, shared by every program declaring the blocks
     glm::mat4 view = camera.getViewMatrix();
     float aspectRatio = (float)windowWidth / (float)windowHeight;
-    glm::mat4 projection = glm::perspective(glm::radians(camera.getFOV()), aspectRatio, 0.1f, 200.0f);
-    m_minecraftShader->setUniform("view", view);
-    m_minecraftShader->setUniform("projection", projection);
-    m_minecraftShader->setUniform("viewPos", camera.getPosition());
-
-    // Bind shadow maps
-    int textureUnit = MAX_BLOCK_TEXTURES;
-    m_minecraftShader->setUniform("lightSpaceMatrix", m_dirLightSpaceMatrix);
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_2D, m_dirShadowMap);
-    m_minecraftShader->setUniformSampler("dirShadowMap", textureUnit++);
-
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_pointShadowMap);
-    m_minecraftShader->setUniformSampler("pointShadowMap", textureUnit++);
-    m_minecraftShader->setUniform("pointFarPlane", POINT_FAR_PLANE);
-
-    for (size_t i = 0; i < spotLights.size(); ++i) {
-        m_minecraftShader->setUniform(("spotLightSpaceMatrices[" + std::to_string(i) + "]").c_str(), m_spotLightSpaceMatrices[i]);
-        glActiveTexture(GL_TEXTURE0 + textureUnit);
-        glBindTexture(GL_TEXTURE_2D, m_spotShadowMaps[i]);
-        m_minecraftShader->setUniformSampler(("spotShadowMaps[" + std::to_string(i) + "]").c_str(), textureUnit++);
-    }
-
-    // Set light uniforms
-    m_minecraftShader->setUniform("dirLight.direction", m_dirLight.direction);
-    m_minecraftShader->setUniform("dirLight.ambient", m_dirLight.ambient);
-    m_minecraftShader->setUniform("dirLight.diffuse", m_dirLight.diffuse);
-    m_minecraftShader->setUniform("dirLight.specular", m_dirLight.specular);
-
-    m_minecraftShader->setUniform("numPointLights", (int)pointLights.size());
-    for (size_t i = 0; i < pointLights.size(); i++) {
-        std::string base = "pointLights[" + std::to_string(i) + "]";
-        m_minecraftShader->setUniform((base + ".position").c_str(), pointLights[i].position);
-        m_minecraftShader->setUniform((base + ".ambient").c_str(), pointLights[i].ambient);
-        m_minecraftShader->setUniform((base + ".diffuse").c_str(), pointLights[i].diffuse);
-        m_minecraftShader->setUniform((base + ".specular").c_str(), pointLights[i].specular);
-        m_minecraftShader->setUniform((base + ".constant").c_str(), pointLights[i].constant);
-        m_minecraftShader->setUniform((base + ".linear").c_str(), pointLights[i].linear);
-        m_minecraftShader->setUniform((base + ".exponant").c_str(), pointLights[i].exponant);
-    }
-
-    m_minecraftShader->setUniform("numSpotLights", (int)spotLights.size());
-    for (size_t i = 0; i < spotLights.size(); i++) {
-        std::string base = "spotLights[" + std::to_string(i) + "]";
-        m_minecraftShader->setUniform((base + ".position").c_str(), spotLights[i].position);
-        m_minecraftShader->setUniform((base + ".direction").c_str(), spotLights[i].direction);
-        m_minecraftShader->setUniform((base + ".ambient").c_str(), spotLights[i].ambient);
-        m_minecraftShader->setUniform((base + ".diffuse").c_str(), spotLights[i].diffuse);
-        m_minecraftShader->setUniform((base + ".specular").c_str(), spotLights[i].specular);
-        m_minecraftShader->setUniform((base + ".constant").c_str(), spotLights[i].constant);
-        m_minecraftShader->setUniform((base + ".linear").c_str(), spotLights[i].linear);
-        m_minecraftShader->setUniform((base + ".exponant").c_str(), spotLights[i].exponant);
-        m_minecraftShader->setUniform((base + ".cosInnerCone").c_str(), spotLights[i].cosInnerCone);
-        m_minecraftShader->setUniform((base + ".cosOuterCone").c_str(), spotLights[i].cosOuterCone);
-    }
-
-    // Material
-    const auto& pathToIndex = Chunk::m_pathToTextureIndex;
-    for (const auto& pair : pathToIndex) {
-        int index = pair.second;
-        // Fetch the correct material configuration using the texture index
-        BlockMaterial mat = Chunk::getMaterialForTextureIndex(index);
-
-        std::string base = "blockMaterials[" + std::to_string(index) + "]";
-        m_minecraftShader->setUniform((base + ".ambient").c_str(), mat.ambient);
-        m_minecraftShader->setUniform((base + ".specular").c_str(), mat.specular);
-        m_minecraftShader->setUniform((base + ".shininess").c_str(), mat.shininess);
+    glm::mat4 projection = glm::perspective(glm::radians(camera.getFOV()), aspectRatio, MAIN_NEAR_PLANE, MAIN_FAR_PLANE);
+    uploadFrameData(view, projection, camera.getPosition());
+
+    // Point lights are binned into view-space clusters; the shader only loops over its cluster's list
+    if (!pointLights.empty()) {
+        m_lightClusters.build(pointLights, view, projection, MAIN_NEAR_PLANE, MAIN_FAR_PLANE, windowWidth, windowHeight);
+        const auto& lightData = m_lightClusters.getLightData();
+        const auto& clusterRanges = m_lightClusters.getClusterRanges();
+        const auto& lightIndices = m_lightClusters.getLightIndices();
+        m_pointLightDataTBO.update(lightData.data(), lightData.size() * sizeof(glm::vec4));
+        m_clusterGridTBO.update(clusterRanges.data(), clusterRanges.size() * sizeof(uint32_t));
+        m_clusterLightIndexTBO.update(lightIndices.data(), lightIndices.size() * sizeof(uint32_t));
+
+        m_pointLightDataTBO.bind(POINT_LIGHT_DATA_UNIT);
+        m_clusterGridTBO.bind(CLUSTER_GRID_UNIT);
+        m_clusterLightIndexTBO.bind(CLUSTER_LIGHT_INDEX_UNIT);
+    }
+    uploadLights(pointLights, spotLights);
+
+    // Bind shadow maps, sampler units were assigned once in setupMainProgram
+    int textureUnit = FIRST_SHADOW_TEXTURE_UNIT;
+    if (m_mainVariant.shadows) {
+        GLState::bindTexture(textureUnit++, GL_TEXTURE_2D_ARRAY, m_dirShadowMaps);
+        GLState::bindTexture(textureUnit++, GL_TEXTURE_2D, m_shadowAtlasTexture);
     }
 
     // Bind block textures
-    for (size_t i = 0; i < pathToIndex.size(); i++) {
-        blockTextures[i].bind(i);
-        m_minecraftShader->setUniformSampler(("blockTextures.diffuseMaps[" + std::to_string(i) + "]").c_str(), i);
-    }
-
-    // Draw world
-    m_minecraftShader->setUniform("model", glm::mat4(1.0f));
-    world.draw();
-
-    // Draw models
-    for (const auto& modelData : scene.models) { // No change needed here
-        if (meshCache.count(modelData.meshFile)) {
-            Mesh* mesh = meshCache.at(modelData.meshFile).get();
-            Texture2D* texture = modelTextureCache.count(modelData.textureFile) ? modelTextureCache.at(modelData.textureFile).get() : nullptr;
-
-            glm::mat4 modelMatrix = glm::mat4(1.0f);
-            modelMatrix = glm::translate(modelMatrix, modelData.position);
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(modelData.rotation.angle), modelData.rotation.axis);
-            modelMatrix = glm::scale(modelMatrix, modelData.scale);
-            m_minecraftShader->setUniform("model", modelMatrix);
-
-            if (texture) {
-                texture->bind(0);
-                m_minecraftShader->setUniformSampler("material.diffuseMap", 0); // For single-textured models
-            }
+    blockTextures->bind(BLOCK_TEXTURE_UNIT);
+
+    // Collect the count from FRAGMENT_QUERY_FRAMES frames ago if it has landed, then reuse its query
+    int querySlot = (int)(m_frameIndex % FRAGMENT_QUERY_FRAMES);
+    GLuint query = m_fragmentQueries[querySlot];
+    if (m_fragmentQueryIssued[querySlot]) {
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &m_mainPassFragments);
+        }
+    }
+    m_fragmentQueryIssued[querySlot] = true;
+
+    // The camera passes skip the sections hidden behind solid terrain, and those outside the frustum
+    glm::mat4 viewProjection = projection * view;
+    const SectionVisibility* visibility = nullptr;
+    if (m_sectionCulling) {
+        m_sectionVisibility.update(world, camera.getPosition());
+        visibility = &m_sectionVisibility;
+    }
+    const OcclusionCuller* occlusion = nullptr;
+    if (m_occlusionCulling) {
+        m_occlusionCuller.wait();
+        occlusion = &m_occlusionCuller;
+    }
 
-            mesh->draw();
+    if (m_deferredShading) {
+        deferredLightingPass(camera, world, scene, meshCache, modelTextureCache, viewProjection, visibility, occlusion, query, windowWidth, windowHeight);
+        return;
+    }
 
-            if (texture) {
-                texture->unbind(0);
-            }
-        }
+    // Depth only, in the same front-to-back order. Models go in too so everything can be tested
+    // with GL_EQUAL; alpha-tested texels are discarded here exactly as the main shader does.
+    if (m_depthPrepass) {
+        recordScene(m_prepassQueue, *m_prepassShader, m_prepassModel, m_prepassUseModelTexture, camera.getPosition(), MAIN_FAR_PLANE,
+                    world, scene, meshCache, &modelTextureCache, &viewProjection, visibility, occlusion);
+        GLState::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        m_prepassQueue.execute();
+        GLState::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+        GLState::depthFunc(GL_EQUAL);
+        GLState::depthMask(GL_FALSE);
     }
 
-    // Unbind all textures
-    for (size_t i = 0; i < pathToIndex.size(); i++) {
-        blockTextures[i].unbind(i);
+    // Sections and models sorted front-to-back, then by state, and drawn in one sweep
+    recordScene(m_mainQueue, *m_minecraftShader, m_mainModel, m_mainUseModelTexture, camera.getPosition(), MAIN_FAR_PLANE,
+                world, scene, meshCache, &modelTextureCache, &viewProjection, visibility, occlusion);
+    glBeginQuery(m_fragmentQueryTarget, query);
+    m_mainQueue.execute();
+    glEndQuery(m_fragmentQueryTarget);
+
+    if (m_depthPrepass) {
+        GLState::depthFunc(GL_LESS);
+        GLState::depthMask(GL_TRUE);
     }
-    for (int i = 0; i < textureUnit - MAX_BLOCK_TEXTURES; ++i) {
-        glActiveTexture(GL_TEXTURE0 + MAX_BLOCK_TEXTURES + i);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    // Textures stay bound: the next frame binds the same ones and GLState skips the calls.
+    // No pass samples a shadow map while rendering into it.
+}
+
+void Renderer::deferredLightingPass(const FPSCamera& camera, const World& world, const Scene& scene,
+                                    const std::map<std::string, std::unique_ptr<Mesh>>& meshCache,
+                                    const std::map<std::string, std::unique_ptr<Texture2D>>& modelTextureCache,
+                                    const glm::mat4& viewProjection, const SectionVisibility* visibility,
+                                    const OcclusionCuller* occlusion, GLuint fragmentQuery, int windowWidth, int windowHeight) {
+    resizeGBuffer(windowWidth, windowHeight);
+
+    // 1. Surfaces: the same sorted draw list as the forward path, with a shader that only stores them
+    GLState::bindFramebuffer(m_gBufferFBO);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    recordScene(m_mainQueue, *m_gBufferShader, m_gBufferModel, m_gBufferUseModelTexture, camera.getPosition(), MAIN_FAR_PLANE,
+                world, scene, meshCache, &modelTextureCache, &viewProjection, visibility, occlusion);
+    m_mainQueue.execute();
+
+    // The debug lines and gizmos drawn after this pass still depth test against the scene
+    GLState::bindReadFramebuffer(m_gBufferFBO);
+    GLState::bindDrawFramebuffer(0);
+    glBlitFramebuffer(0, 0, windowWidth, windowHeight, 0, 0, windowWidth, windowHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    GLState::bindFramebuffer(0);
+
+    // 2. Lighting once per covered pixel. Point lights come from the same clusters as in forward
+    // mode, spot lights and the shadow maps bound by mainRenderPass are shared too.
+    for (int i = 0; i < GBUFFER_TARGETS; i++) {
+        GLState::bindTexture(FIRST_GBUFFER_UNIT + i, GL_TEXTURE_2D, m_gBufferTextures[i]);
     }
+    GLState::bindTexture(FIRST_GBUFFER_UNIT + GBUFFER_TARGETS, GL_TEXTURE_2D, m_gBufferDepth);
+
+    m_minecraftShader->use();
+    m_minecraftShader->setUniform(m_mainClipToWorld, glm::inverse(viewProjection));
+    GLState::disable(GL_DEPTH_TEST);
+    GLState::bindVertexArray(m_fullscreenVAO);
+    glBeginQuery(m_fragmentQueryTarget, fragmentQuery);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEndQuery(m_fragmentQueryTarget);
+    GLState::enable(GL_DEPTH_TEST);
 }
 
 void Renderer::drawCrosshair(int windowWidth, int windowHeight) {
@@ -480,7 +1249,7 @@ void Renderer::drawCrosshair(int windowWidth, int windowHeight) {
         centerX, centerY - size - gap, 0.0f
     };
 
-    glBindVertexArray(m_crosshairVAO);
+    GLState::bindVertexArray(m_crosshairVAO);
     glBindBuffer(GL_ARRAY_BUFFER, m_crosshairVBO);
     glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
 
@@ -489,11 +1258,11 @@ void Renderer::drawCrosshair(int windowWidth, int windowHeight) {
     m_crosshairShader->use();
     m_crosshairShader->setUniform("projection", ortho);
 
-    glDisable(GL_DEPTH_TEST);
+    GLState::disable(GL_DEPTH_TEST);
     glLineWidth(2.0f);
-    glBindVertexArray(m_crosshairVAO);
+    GLState::bindVertexArray(m_crosshairVAO);
     glDrawArrays(GL_LINES, 0, 8);
-    glEnable(GL_DEPTH_TEST);
+    GLState::enable(GL_DEPTH_TEST);
 }
 
 void Renderer::initGUIMesh() {
@@ -511,7 +1280,7 @@ void Renderer::initGUIMesh() {
 
     glGenVertexArrays(1, &m_guiVAO);
     glGenBuffers(1, &m_guiVBO);
-    glBindVertexArray(m_guiVAO);
+    GLState::bindVertexArray(m_guiVAO);
     glBindBuffer(GL_ARRAY_BUFFER, m_guiVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
@@ -521,10 +1290,10 @@ void Renderer::initGUIMesh() {
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
 
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
-void Renderer::drawInventoryHUD(const Texture2D* blockTextures, int numTextures, int selectedIndex,
+void Renderer::drawInventoryHUD(const TextureArray* blockTextures, int numTextures, int selectedIndex,
                                const std::vector<BlockType>& selectableBlocks,
                                int windowWidth, int windowHeight) {
     if (m_guiVAO == 0 || selectableBlocks.empty()) return;
@@ -537,10 +1306,13 @@ void Renderer::drawInventoryHUD(const Texture2D* blockTextures, int numTextures,
     glm::mat4 ortho = glm::ortho(0.0f, (float)windowWidth, 0.0f, (float)windowHeight);
     m_guiShader->setUniform("projection", ortho);
 
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_CULL_FACE);
+    // Icons and frames are layers of the block texture array
+    blockTextures->bind(1);
+
+    GLState::disable(GL_DEPTH_TEST);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::disable(GL_CULL_FACE);
 
     float iconSize = 64.0f;
     float padding = 10.0f;
@@ -551,11 +1323,10 @@ void Renderer::drawInventoryHUD(const Texture2D* blockTextures, int numTextures,
     float frameSize = iconSize + 10.0f;
     float frameOffset = (iconSize - frameSize) / 2.0f;
 
-    int safeTextureIndex = 10;
+    const int frameLayer = BlockRegistry::getIconLayer(BlockType::HUD);
+    const int selectedFrameLayer = BlockRegistry::getIconLayer(BlockType::HUD_SELECTED);
 
-    glBindVertexArray(m_guiVAO);
-
-    const auto& pathToIndex = Chunk::m_pathToTextureIndex;
+    GLState::bindVertexArray(m_guiVAO);
 
     for (size_t i = 0; i < selectableBlocks.size(); ++i) {
         BlockType type = selectableBlocks[i];
@@ -567,61 +1338,41 @@ void Renderer::drawInventoryHUD(const Texture2D* blockTextures, int numTextures,
             glm::mat4 frameModel = glm::mat4(1.0f);
             frameModel = glm::translate(frameModel, glm::vec3(currentX + frameOffset, currentY + frameOffset, 0.0f));
             frameModel = glm::scale(frameModel, glm::vec3(frameSize, frameSize, 1.0f));
-            m_guiShader->setUniform("model", frameModel);
+            m_guiShader->setUniform(m_guiModel, frameModel);
 
-            blockTextures[safeTextureIndex+1].bind(0);
-            m_guiShader->setUniformSampler("guiTexture", 0);
-            m_guiShader->setUniform("tintColor", glm::vec3(1.0f, 1.0f, 1.0f)); // Cadre purement blanc
+            m_guiShader->setUniform(m_guiLayer, selectedFrameLayer);
+            m_guiShader->setUniform(m_guiTintColor, glm::vec3(1.0f, 1.0f, 1.0f)); // Cadre purement blanc
             glDrawArrays(GL_TRIANGLES, 0, 6);
-            blockTextures[safeTextureIndex+1].unbind(0);
         } else {
             glm::mat4 frameModel = glm::mat4(1.0f);
             frameModel = glm::translate(frameModel, glm::vec3(currentX + frameOffset, currentY + frameOffset, 0.0f));
             frameModel = glm::scale(frameModel, glm::vec3(frameSize, frameSize, 1.0f));
-            m_guiShader->setUniform("model", frameModel);
+            m_guiShader->setUniform(m_guiModel, frameModel);
 
-            blockTextures[safeTextureIndex].bind(0);
-            m_guiShader->setUniformSampler("guiTexture", 0);
-            m_guiShader->setUniform("tintColor", glm::vec3(1.0f, 1.0f, 1.0f)); // Cadre purement blanc
+            m_guiShader->setUniform(m_guiLayer, frameLayer);
+            m_guiShader->setUniform(m_guiTintColor, glm::vec3(1.0f, 1.0f, 1.0f)); // Cadre purement blanc
             glDrawArrays(GL_TRIANGLES, 0, 6);
-            blockTextures[safeTextureIndex].unbind(0);
-        }
-
-        std::string texturePath = "";
-        if (Chunk::m_textureConfig.count(type)) {
-            const auto& config = Chunk::m_textureConfig.at(type);
-            texturePath = config.special.empty() ? config.top : config.special;
-        }
-
-        if (texturePath.empty()) continue;
-
-        int textureIndex = -1;
-        if (pathToIndex.count(texturePath)) {
-            textureIndex = pathToIndex.at(texturePath);
         }
 
+        int textureIndex = BlockRegistry::getIconLayer(type);
         if (textureIndex == -1 || textureIndex >= numTextures) continue;
 
         glm::mat4 iconModel = glm::mat4(1.0f);
         iconModel = glm::translate(iconModel, glm::vec3(currentX, currentY, 0.0f));
         iconModel = glm::scale(iconModel, glm::vec3(iconSize, iconSize, 1.0f));
-        m_guiShader->setUniform("model", iconModel);
+        m_guiShader->setUniform(m_guiModel, iconModel);
 
-        blockTextures[textureIndex].bind(0);
-        m_guiShader->setUniformSampler("guiTexture", 0);
-
-        m_guiShader->setUniform("tintColor", glm::vec3(1.0f));
+        m_guiShader->setUniform(m_guiLayer, textureIndex);
+        m_guiShader->setUniform(m_guiTintColor, glm::vec3(1.0f));
 
         glDrawArrays(GL_TRIANGLES, 0, 6);
-
-        blockTextures[textureIndex].unbind(0);
     }
 
-    glBindVertexArray(0);
+    m_guiShader->setUniform(m_guiLayer, -1);
 
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::disable(GL_BLEND);
+    GLState::enable(GL_CULL_FACE);
 }
 
 void Renderer::drawSunGizmo(const FPSCamera& camera, int windowWidth, int windowHeight, bool debug) {
@@ -635,8 +1386,8 @@ void Renderer::drawSunGizmo(const FPSCamera& camera, int windowWidth, int window
 
     m_guiShader->use();
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     glm::mat4 model = glm::mat4(1.0f);
 
@@ -651,7 +1402,7 @@ void Renderer::drawSunGizmo(const FPSCamera& camera, int windowWidth, int window
 
         // Vérifier si le soleil est derrière
         if (sunClipSpace.w < 0.0f) {
-            glDisable(GL_BLEND);
+            GLState::disable(GL_BLEND);
             return;
         }
 
@@ -666,7 +1417,7 @@ void Renderer::drawSunGizmo(const FPSCamera& camera, int windowWidth, int window
         m_guiShader->setUniform("view", glm::mat4(1.0f));
         m_guiShader->setUniform("projection", ortho);
 
-        glDisable(GL_DEPTH_TEST);
+        GLState::disable(GL_DEPTH_TEST);
 
         // Positionnement et mise à l'échelle en 2D (taille fixe GIZMO_PIXEL_SIZE)
         model = glm::translate(model, glm::vec3(screenX - GIZMO_PIXEL_SIZE / 2.0f, screenY - GIZMO_PIXEL_SIZE / 2.0f, 0.0f));
@@ -684,7 +1435,7 @@ void Renderer::drawSunGizmo(const FPSCamera& camera, int windowWidth, int window
         m_guiShader->setUniform("view", view);
         m_guiShader->setUniform("projection", projection);
 
-        glEnable(GL_DEPTH_TEST);
+        GLState::enable(GL_DEPTH_TEST);
 
         // 3. Modèle 3D: Position + Billboard + Redimensionnement
 
@@ -713,15 +1464,12 @@ void Renderer::drawSunGizmo(const FPSCamera& camera, int windowWidth, int window
     m_guiShader->setUniform("model", model);
     m_guiShader->setUniform("tintColor", glm::vec3(1.0f, 1.0f, 0.0f));
     m_whiteTexture->bind(0);
-    m_guiShader->setUniformSampler("guiTexture", 0);
 
-    glBindVertexArray(m_guiVAO);
+    GLState::bindVertexArray(m_guiVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
 
     // Nettoyage
     m_guiShader->setUniform("is3D", 0);
-    m_whiteTexture->unbind(0);
-    glDisable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST);
+    GLState::disable(GL_BLEND);
+    GLState::enable(GL_DEPTH_TEST);
 }
\ No newline at end of file
@@ -7,12 +7,23 @@
 #include <glm/glm.hpp>
 
 #include "ShaderProgram.h"
+#include "ShaderVariantCache.h"
 #include "Camera.h"
 #include "World.h"
 #include "Scene.h"
 #include "Mesh.h"
 #include "Texture2D.h"
+#include "TextureArray.h"
 #include "Light.h"
+#include "UniformBuffer.h"
+#include "RenderQueue.h"
+#include "TextureBuffer.h"
+#include "LightClusterGrid.h"
+#include "LightAggregator.h"
+#include "ShadowAtlas.h"
+#include "SectionVisibility.h"
+#include "OcclusionCuller.h"
+#include "Constants.h"
 
 class Renderer {
 public:
@@ -23,12 +34,12 @@ public:
     void render(const FPSCamera& camera, const World& world, const Scene& scene,
                 const std::map<std::string, std::unique_ptr<Mesh>>& meshCache,
                 const std::map<std::string, std::unique_ptr<Texture2D>>& modelTextureCache,
-                const Texture2D* blockTextures,
+                const TextureArray* blockTextures,
                 int windowWidth, int windowHeight);
 
     void drawCrosshair(int windowWidth, int windowHeight);
 
-    void drawInventoryHUD(const Texture2D* blockTextures, int numTextures, int selectedIndex,
+    void drawInventoryHUD(const TextureArray* blockTextures, int numTextures, int selectedIndex,
                           const std::vector<BlockType>& selectableBlocks,
                           int windowWidth, int windowHeight
     );
@@ -37,15 +48,94 @@ public:
 
     void updateSun(float deltaTime);
 
+    // Selects the shadowed or shadowless shader variants and skips the shadow passes.
+    // Without shadow maps, the sun is occluded by the sky light baked into chunk vertices.
+    void setShadowsEnabled(bool enabled) { m_shadowsEnabled = enabled; }
+    bool getShadowsEnabled() const { return m_shadowsEnabled; }
+    // PCF kernel radius for spot and point shadows: 0 = single tap, 1 = 3x3, 2 = 5x5
+    void setPCFRadius(int radius) { m_pcfRadius = glm::clamp(radius, 0, 2); }
+    // Emitters are lit by the block light baked into chunk vertices. Dynamic mode instead turns every
+    // emitter into per-pixel point lights, with specular highlights and point shadows.
+    void setDynamicBlockLights(bool enabled) { m_dynamicBlockLights = enabled; }
+    bool getDynamicBlockLights() const { return m_dynamicBlockLights; }
+    // Emitter selection of the last frame, all zero in baked mode
+    const LightIndex::QueryStats& getLightSelectionStats() const { return m_lightSelectionStats; }
+    // Point lights left after merging the selected ones
+    int getAggregatedLightCount() const { return m_dynamicBlockLights ? m_lightAggregator.getOutputCount() : 0; }
+
+    // Shadow maps are cached. A local light's tiles are redrawn at once when the light moves or its
+    // tile changes, and within a per-frame budget when something in its range changes; each sun
+    // cascade when the sun turns, its frustum slice moves by a texel or the world inside it changes.
+    // These hooks report world edits (as a world-space box) and moved scene models.
+    void invalidateShadows(const glm::vec3& boxMin, const glm::vec3& boxMax);
+    void onModelChanged(size_t modelIndex);
+    // Sun maps and local shadow tiles re-rendered during the last frame
+    int getShadowMapUpdates() const { return m_shadowMapUpdates; }
+
+    // Lays down the depth of the opaque scene with a cheap program first, so the lighting shader
+    // only runs (GL_EQUAL) on the fragments that end up visible
+    void setDepthPrepassEnabled(bool enabled) { m_depthPrepass = enabled; }
+    bool getDepthPrepassEnabled() const { return m_depthPrepass; }
+    // Fragments the main pass shaded, read back a few frames late to avoid stalling. Counts
+    // fragment shader invocations where the driver exposes them, else samples that passed.
+    GLuint64 getMainPassFragments() const { return m_mainPassFragments; }
+    bool countsShaderInvocations() const { return m_fragmentQueryTarget != GL_SAMPLES_PASSED; }
+    // Writes surfaces to a G-buffer and lights each pixel once, with the same lights, clusters
+    // and shadow maps as the forward path. The depth pre-pass only applies to forward shading.
+    void setDeferredShading(bool enabled) { m_deferredShading = enabled; }
+    bool getDeferredShading() const { return m_deferredShading; }
+    // Camera passes draw only the sections reachable from the eye through open space (see
+    // SectionVisibility); shadow passes still draw every caster
+    void setSectionCulling(bool enabled) { m_sectionCulling = enabled; }
+    bool getSectionCulling() const { return m_sectionCulling; }
+    // Sections the visibility walk reached last frame, out of all sections
+    int getVisibleSectionCount() const { return m_sectionVisibility.getVisibleCount(); }
+    int getSectionCount() const { return m_sectionVisibility.getSectionCount(); }
+    // Camera passes also skip sections hidden behind solid terrain in a software depth buffer
+    // (see OcclusionCuller), computed on a worker thread during the shadow passes
+    void setOcclusionCulling(bool enabled) { m_occlusionCulling = enabled; }
+    bool getOcclusionCulling() const { return m_occlusionCulling; }
+    const OcclusionCuller& getOcclusionCuller() const { return m_occlusionCuller; }
+
 private:
     void initShaders();
     void initShadows();
     void initCrosshair();
     void initGUIMesh();
+    void initUniformBuffers();
+    void initQueries();
+    void setupMainProgram(ShaderProgram& program);
+    void selectMainShader(int pointLightCount, int spotLightCount);
+    // (Re)allocates the G-buffer targets when the window size changes
+    void resizeGBuffer(int width, int height);
 
-    void renderScene(ShaderProgram& shader, const World& world, const Scene& scene, const std::map<std::string, std::unique_ptr<Mesh>>& meshCache);
+    void uploadBlockMaterials();
+    void uploadFrameData(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos);
+    void uploadLights(const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights);
 
-    void dirShadowPass(const FPSCamera& camera, const World& world, const Scene& scene, const std::map<std::string, std::unique_ptr<Mesh>>& meshCache, const Texture2D* blockTextures);
+    // Records chunk sections and models into queue, ordered from eye. Model textures are only
+    // recorded when a texture cache is given (the depth passes do not sample them). With a cull
+    // matrix, sections entirely outside its clip volume are left out, and with a visibility those
+    // it did not reach, and with an occlusion culler those it found hidden.
+    void recordScene(RenderQueue& queue, ShaderProgram& shader, ShaderProgram::Uniform<glm::mat4> modelUniform,
+                     ShaderProgram::Uniform<GLint> materialUniform, const glm::vec3& eye, float maxDepth,
+                     const World& world, const Scene& scene, const std::map<std::string, std::unique_ptr<Mesh>>& meshCache,
+                     const std::map<std::string, std::unique_ptr<Texture2D>>* modelTextureCache,
+                     const glm::mat4* cullMatrix = nullptr, const SectionVisibility* visibility = nullptr,
+                     const OcclusionCuller* occlusion = nullptr);
+
+    // Turns the models moved since the last frame into shadow invalidations, now that their meshes are known
+    void updateModelShadowBounds(const Scene& scene, const std::map<std::string, std::unique_ptr<Mesh>>& meshCache);
+    void dirShadowPass(const FPSCamera& camera, float aspectRatio, const World& world, const Scene& scene, const std::map<std::string, std::unique_ptr<Mesh>>& meshCache, const TextureArray* blockTextures);
+    // Sections go only to the cube faces they overlap, through the geometry shader's faceMask
+    void recordPointShadowCasters(const glm::vec3& lightPos, const World& world, const Scene& scene,
+                                  const std::map<std::string, std::unique_ptr<Mesh>>& meshCache);
+    // Sizes every local light's tiles from its projected size and packs them into the atlas
+    void packShadowAtlas(const FPSCamera& camera, const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights);
+    // Picks the atlas requests redrawn this frame into m_shadowTileUpdates and builds the next cache
+    void scheduleShadowUpdates(const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights);
+    struct CachedShadow;
+    const CachedShadow* findCachedShadow(const CachedShadow& wanted) const;
     void pointShadowPass(const std::vector<PointLight>& pointLights, const World& world, const Scene& scene,
                          const std::map<std::string, std::unique_ptr<Mesh>>& meshCache);
     void spotShadowPass(const std::vector<SpotLight>& spotLights, const World& world, const Scene& scene,
@@ -53,26 +143,161 @@ private:
     void mainRenderPass(const FPSCamera& camera, const World& world, const Scene& scene,
                         const std::map<std::string, std::unique_ptr<Mesh>>& meshCache,
                         const std::map<std::string, std::unique_ptr<Texture2D>>& modelTextureCache,
-                        const Texture2D* blockTextures,
+                        const TextureArray* blockTextures,
                         const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights,
                         int windowWidth, int windowHeight);
+    // Tail of mainRenderPass in deferred mode, once lights, shadows and frame data are bound
+    void deferredLightingPass(const FPSCamera& camera, const World& world, const Scene& scene,
+                              const std::map<std::string, std::unique_ptr<Mesh>>& meshCache,
+                              const std::map<std::string, std::unique_ptr<Texture2D>>& modelTextureCache,
+                              const glm::mat4& viewProjection, const SectionVisibility* visibility,
+                              const OcclusionCuller* occlusion, GLuint fragmentQuery, int windowWidth, int windowHeight);
 
-    // Shaders
-    std::unique_ptr<ShaderProgram> m_minecraftShader;
+    // Shaders. The main program is one variant of minecraft.frag, picked per frame from the light set.
+    std::unique_ptr<ShaderVariantCache> m_minecraftVariants;
+    std::unique_ptr<ShaderVariantCache> m_deferredVariants;
+    ShaderProgram* m_minecraftShader = nullptr;
+    std::unique_ptr<ShaderProgram> m_gBufferShader;
     std::unique_ptr<ShaderProgram> m_depthShader;
+    std::unique_ptr<ShaderProgram> m_prepassShader;
     std::unique_ptr<ShaderProgram> m_pointDepthShader;
     std::unique_ptr<ShaderProgram> m_crosshairShader;
     std::unique_ptr<ShaderProgram> m_guiShader;
 
+    struct MainVariantKey {
+        bool pointLights = true;
+        int spotLightBucket = -1;
+        bool shadows = true;
+        bool cutout = true;
+        int pcfRadius = 1;
+        bool bakedBlockLight = true;
+        bool deferred = false;
+
+        bool operator==(const MainVariantKey& other) const {
+            return pointLights == other.pointLights && spotLightBucket == other.spotLightBucket
+                && shadows == other.shadows && cutout == other.cutout && pcfRadius == other.pcfRadius
+                && bakedBlockLight == other.bakedBlockLight && deferred == other.deferred;
+        }
+    };
+    MainVariantKey m_mainVariant;
+
+    bool m_shadowsEnabled = true;
+    bool m_hasCutoutLayers = true;
+    int m_pcfRadius = 1;
+    bool m_dynamicBlockLights = false;
+    LightIndex::QueryStats m_lightSelectionStats;
+    std::vector<PointLight> m_selectedLights; // Scratch, one light per selected emitter
+    LightAggregator m_lightAggregator;
+
+    // Uniforms set inside draw loops, resolved once after the programs link
+    ShaderProgram::Uniform<glm::mat4> m_mainModel;
+    ShaderProgram::Uniform<GLint> m_mainUseModelTexture;
+    ShaderProgram::Uniform<glm::mat4> m_mainClipToWorld; // Deferred variants only
+    ShaderProgram::Uniform<glm::mat4> m_gBufferModel;
+    ShaderProgram::Uniform<GLint> m_gBufferUseModelTexture;
+    ShaderProgram::Uniform<glm::mat4> m_prepassModel;
+    ShaderProgram::Uniform<GLint> m_prepassUseModelTexture;
+    ShaderProgram::Uniform<glm::mat4> m_depthModel, m_depthLightSpaceMatrix;
+    ShaderProgram::Uniform<glm::mat4> m_pointDepthModel, m_pointDepthFaceMatrices[6];
+    ShaderProgram::Uniform<glm::vec4> m_pointDepthFaceTiles[6];
+    ShaderProgram::Uniform<GLint> m_pointDepthFaceMask;
+    ShaderProgram::Uniform<glm::mat4> m_guiModel;
+    ShaderProgram::Uniform<GLint> m_guiLayer;
+    ShaderProgram::Uniform<glm::vec3> m_guiTintColor;
+
+    // Block material table, indexed by texture layer. Re-uploaded only when the registry version changes.
+    UniformBuffer m_blockMaterialUBO;
+    unsigned int m_blockMaterialVersion = 0;
+
+    // Camera and light data, rewritten once per frame
+    UniformBuffer m_frameDataUBO;
+    UniformBuffer m_lightsUBO;
+
+    // Clustered point lights: light records, per-cluster (offset, count) and the index lists
+    LightClusterGrid m_lightClusters;
+    TextureBuffer m_pointLightDataTBO;
+    TextureBuffer m_clusterGridTBO;
+    TextureBuffer m_clusterLightIndexTBO;
+
+    // Per-pass draw lists, reused every frame
+    RenderQueue m_mainQueue;
+    RenderQueue m_prepassQueue;
+    RenderQueue m_shadowQueue;
+
+    // Depth pre-pass, and the main pass fragment count: a ring of queries so results are read
+    // once they are ready rather than waited for
+    static const int FRAGMENT_QUERY_FRAMES = 3;
+    bool m_depthPrepass = false;
+    GLenum m_fragmentQueryTarget = GL_SAMPLES_PASSED;
+    GLuint m_fragmentQueries[FRAGMENT_QUERY_FRAMES] = {};
+    bool m_fragmentQueryIssued[FRAGMENT_QUERY_FRAMES] = {};
+    GLuint64 m_mainPassFragments = 0;
+
+    bool m_sectionCulling = true;
+    SectionVisibility m_sectionVisibility;
+    bool m_occlusionCulling = true;
+    OcclusionCuller m_occlusionCuller;
+
+    // Deferred shading: G-buffer sized to the window, and the empty VAO the full-screen triangle needs
+    static const int GBUFFER_TARGETS = 3;
+    bool m_deferredShading = false;
+    GLuint m_gBufferFBO = 0, m_gBufferTextures[GBUFFER_TARGETS] = {}, m_gBufferDepth = 0;
+    int m_gBufferWidth = 0, m_gBufferHeight = 0;
+    GLuint m_fullscreenVAO = 0;
+
     // Shadow Maps
-    GLuint m_dirShadowMapFBO = 0, m_dirShadowMap = 0;
-    GLuint m_pointShadowMapFBO = 0, m_pointShadowMap = 0;
-    std::vector<GLuint> m_spotShadowMapFBOs, m_spotShadowMaps;
+    GLuint m_dirShadowMapFBO = 0, m_dirShadowMaps = 0;
+    GLuint m_shadowAtlasFBO = 0, m_shadowAtlasTexture = 0;
+
+    // Tile layout of the atlas for this frame: point lights first, then spot lights
+    ShadowAtlas m_shadowAtlas;
+    int m_pointShadowCount = 0;
+    int m_spotShadowCount = 0;
 
     // Shadow matrices
-    glm::mat4 m_dirLightSpaceMatrix;
     std::vector<glm::mat4> m_spotLightSpaceMatrices;
 
+    // Sun cascades, nearest first, and what each layer was rendered for
+    struct DirCascade {
+        bool valid = false;
+        glm::ivec3 snappedCenter = glm::ivec3(0); // Light space, in texels
+        float radius = 0.0f;
+        glm::vec3 direction = glm::vec3(0.0f);
+        glm::mat4 lightSpace = glm::mat4(1.0f);
+        float splitFar = 0.0f;  // View depth the cascade covers up to
+        float depthBias = 0.0f; // Shadow map depth units
+    };
+    DirCascade m_dirCascades[DIR_SHADOW_CASCADES];
+
+    // What a light's atlas tiles were rendered for. Point lights own six tiles from the first one
+    // and only use the position.
+    struct CachedShadow {
+        bool valid = false;
+        bool dirty = false;    // Geometry in range changed since; still usable until redrawn
+        float waiting = 0.0f;  // Importance accumulated while dirty, for the round-robin
+        bool point = false;
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 direction = glm::vec3(0.0f);
+        float cosOuterCone = 0.0f;
+        ShadowAtlas::Tile tile = {};
+    };
+    std::vector<CachedShadow> m_shadowCache;     // Tiles as of the last frame
+    std::vector<CachedShadow> m_nextShadowCache; // One entry per atlas request of this frame
+    std::vector<bool> m_shadowTileUpdates;       // Per atlas request: redraw this frame
+    std::vector<int> m_staleShadowRequests;      // Scratch
+    unsigned int m_frameIndex = 0;
+    int m_shadowMapUpdates = 0;
+
+
+    // World-space bounds each model had when shadows last saw it, and the models moved since
+    struct Bounds {
+        bool known = false;
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+    };
+    std::vector<Bounds> m_modelShadowBounds;
+    std::vector<size_t> m_changedModels;
+
     // Crosshair
     GLuint m_crosshairVAO = 0, m_crosshairVBO = 0;
     GLuint m_guiVAO = 0, m_guiVBO = 0;
@@ -5,18 +5,38 @@
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Model.h"
+#include <functional>
 #include <vector>
 
 extern Model endermanModel;
 
 class Scene {
 public:
+    // Called with the index of a model after it moved through one of the setters below
+    using ModelChangeListener = std::function<void(size_t modelIndex)>;
+
     Scene() {
         models.push_back(endermanModel);
     }
     ~Scene() = default;
 
+    void addModelChangeListener(ModelChangeListener listener) { mModelChangeListeners.push_back(std::move(listener)); }
+
+    void setModelPosition(size_t index, const glm::vec3& position) {
+        models[index].position = position;
+        notifyModelChanged(index);
+    }
+
     std::vector<Model> models;
+
+private:
+    void notifyModelChanged(size_t index) {
+        for (const auto& listener : mModelChangeListeners) {
+            listener(index);
+        }
+    }
+
+    std::vector<ModelChangeListener> mModelChangeListeners;
 };
 
 #endif // SCENE_H
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "SectionVisibility.h"
+#include "World.h"
+#include <cmath>
+
+namespace {
+    const Chunk::SectionFace OPPOSITE_FACE[Chunk::SECTION_FACE_COUNT] = {
+        Chunk::SECTION_NEG_X, Chunk::SECTION_POS_X,
+        Chunk::SECTION_NEG_Y, Chunk::SECTION_POS_Y,
+        Chunk::SECTION_NEG_Z, Chunk::SECTION_POS_Z
+    };
+}
+
+void SectionVisibility::visit(int chunkIndex, int section, int entryFace, int travelledMask) {
+    unsigned char& visible = mVisible[chunkIndex * Chunk::SECTION_COUNT + section];
+    if (visible) return;
+    visible = 1;
+    mVisibleCount++;
+    mQueue.push_back({ chunkIndex, section, entryFace, travelledMask });
+}
+
+void SectionVisibility::update(const World& world, const glm::vec3& eye) {
+    const std::vector<Chunk*>& chunks = world.getChunks();
+    mVisible.assign(chunks.size() * Chunk::SECTION_COUNT, 0);
+    mVisibleCount = 0;
+    mQueue.clear();
+
+    mChunkIndices.clear();
+    for (int i = 0; i < (int)chunks.size(); i++) {
+        mChunkIndices[chunks[i]] = i;
+    }
+
+    // Blocks are centred on integer coordinates
+    Chunk* eyeChunk = world.getChunkAt(glm::round(eye));
+    auto eyeChunkIt = mChunkIndices.find(eyeChunk);
+    if (eyeChunkIt == mChunkIndices.end()) {
+        // Outside the loaded area every section may be in view
+        mVisible.assign(mVisible.size(), 1);
+        mVisibleCount = (int)mVisible.size();
+        return;
+    }
+
+    int eyeSection = (int)std::floor((eye.y + 0.5f) / Chunk::SECTION_HEIGHT);
+    if (eyeSection >= Chunk::SECTION_COUNT) {
+        // Above the world: look in through the top of every column
+        for (int i = 0; i < (int)chunks.size(); i++) {
+            visit(i, Chunk::SECTION_COUNT - 1, Chunk::SECTION_POS_Y, 1 << Chunk::SECTION_NEG_Y);
+        }
+    } else if (eyeSection < 0) {
+        for (int i = 0; i < (int)chunks.size(); i++) {
+            visit(i, 0, Chunk::SECTION_NEG_Y, 1 << Chunk::SECTION_POS_Y);
+        }
+    } else {
+        visit(eyeChunkIt->second, eyeSection, -1, 0);
+    }
+
+    // mQueue grows while it is walked, head marks the next node
+    for (size_t head = 0; head < mQueue.size(); head++) {
+        Node node = mQueue[head];
+        const Chunk* chunk = chunks[node.chunkIndex];
+
+        for (int face = 0; face < Chunk::SECTION_FACE_COUNT; face++) {
+            Chunk::SectionFace exit = (Chunk::SectionFace)face;
+            if (node.travelledMask & (1 << OPPOSITE_FACE[face])) continue;
+            if (node.entryFace >= 0 && !chunk->areSectionFacesConnected(node.section, (Chunk::SectionFace)node.entryFace, exit)) continue;
+
+            int chunkIndex = node.chunkIndex;
+            int section = node.section;
+            const Chunk* neighbour = chunk;
+            switch (exit) {
+                case Chunk::SECTION_POS_Y: section++; break;
+                case Chunk::SECTION_NEG_Y: section--; break;
+                case Chunk::SECTION_POS_X: neighbour = chunk->getNeighbour(Chunk::SIDE_POS_X); break;
+                case Chunk::SECTION_NEG_X: neighbour = chunk->getNeighbour(Chunk::SIDE_NEG_X); break;
+                case Chunk::SECTION_POS_Z: neighbour = chunk->getNeighbour(Chunk::SIDE_POS_Z); break;
+                case Chunk::SECTION_NEG_Z: neighbour = chunk->getNeighbour(Chunk::SIDE_NEG_Z); break;
+                default: break;
+            }
+            if (section < 0 || section >= Chunk::SECTION_COUNT || !neighbour) continue;
+            if (neighbour != chunk) chunkIndex = mChunkIndices[neighbour];
+
+            visit(chunkIndex, section, OPPOSITE_FACE[face], node.travelledMask | (1 << face));
+        }
+    }
+}
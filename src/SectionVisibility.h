@@ -0,0 +1,40 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Chunk.h"
+
+class World;
+
+// Chunk sections the eye can see into, found by a breadth-first walk from the eye's section
+// through section faces that connect across open space (the visibility graph Minecraft uses).
+// The walk never steps back towards the eye, so it cannot wrap around solid terrain. It knows
+// nothing of the view frustum; the caller still frustum culls what it finds.
+class SectionVisibility {
+public:
+    void update(const World& world, const glm::vec3& eye);
+
+    // chunkIndex is the chunk's position in World::getChunks()
+    bool isVisible(int chunkIndex, int section) const { return mVisible[chunkIndex * Chunk::SECTION_COUNT + section] != 0; }
+    const std::vector<unsigned char>& getVisibleFlags() const { return mVisible; }
+
+    int getVisibleCount() const { return mVisibleCount; }
+    int getSectionCount() const { return (int)mVisible.size(); }
+
+private:
+    struct Node {
+        int chunkIndex;
+        int section;
+        int entryFace;     // Chunk::SectionFace the walk came in through, -1 for the eye's section
+        int travelledMask; // Directions stepped so far, as SectionFace bits
+    };
+
+    void visit(int chunkIndex, int section, int entryFace, int travelledMask);
+
+    std::vector<unsigned char> mVisible;
+    std::vector<Node> mQueue;
+    std::unordered_map<const Chunk*, int> mChunkIndices;
+    int mVisibleCount = 0;
+};
@@ -1,7 +1,10 @@
 #include "ShaderProgram.h"
+#include "GLState.h"
+#include "ProgramBinaryCache.h"
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include "glm/gtc/type_ptr.hpp"
 
@@ -9,13 +12,28 @@ ShaderProgram::ShaderProgram() : mHandle(0) {
 }
 
 ShaderProgram::~ShaderProgram() {
-        glDeleteProgram(mHandle);
+        GLState::deleteProgram(mHandle);
 }
 
 
-bool ShaderProgram::loadShaders(const char* vsFilename, const char* fsFilename) {
-        string vsString = fileToString(vsFilename);
-        string fsString = fileToString(fsFilename);
+bool ShaderProgram::loadShaders(const char* vsFilename, const char* fsFilename, const string& defines) {
+        return loadShaders(vsFilename, nullptr, fsFilename, defines);
+}
+
+bool ShaderProgram::loadShaders(const char* vsFilename, const char* gsFilename, const char* fsFilename, const string& defines) {
+        string vsString = injectDefines(fileToString(vsFilename), defines);
+        string gsString = gsFilename ? injectDefines(fileToString(gsFilename), defines) : string();
+        string fsString = injectDefines(fileToString(fsFilename), defines);
+        mName = string(vsFilename) + " + " + (gsFilename ? string(gsFilename) + " + " : string()) + fsFilename;
+
+        // A cached binary skips compilation and linking entirely
+        uint64_t cacheKey = ProgramBinaryCache::makeKey(vsString, fsString, gsString);
+        mHandle = glCreateProgram();
+        if (ProgramBinaryCache::load(cacheKey, mHandle)) {
+                introspect();
+                return true;
+        }
+
         const GLchar* vsSourcePtr = vsString.c_str();
         const GLchar* fsSourcePtr = fsString.c_str();
 
@@ -31,23 +49,45 @@ bool ShaderProgram::loadShaders(const char* vsFilename, const char* fsFilename)
         glCompileShader(fs);
         checkCompileErrors(fs, FRAGMENT);
 
-        mHandle = glCreateProgram();
+        GLuint gs = 0;
+        if (gsFilename) {
+                const GLchar* gsSourcePtr = gsString.c_str();
+                gs = glCreateShader(GL_GEOMETRY_SHADER);
+                glShaderSource(gs, 1, &gsSourcePtr, NULL);
+                glCompileShader(gs);
+                checkCompileErrors(gs, GEOMETRY);
+        }
+
         glAttachShader(mHandle, vs);
+        if (gs) glAttachShader(mHandle, gs);
         glAttachShader(mHandle, fs);
+        ProgramBinaryCache::prepareForLink(mHandle);
         glLinkProgram(mHandle);
         checkCompileErrors(mHandle, PROGRAM);
 
+        glDetachShader(mHandle, vs);
+        glDetachShader(mHandle, fs);
         glDeleteShader(vs);
         glDeleteShader(fs);
+        if (gs) {
+                glDetachShader(mHandle, gs);
+                glDeleteShader(gs);
+        }
 
-        mUniformLocations.clear();
+        GLint linked = GL_FALSE;
+        glGetProgramiv(mHandle, GL_LINK_STATUS, &linked);
+        if (linked == GL_TRUE) {
+                ProgramBinaryCache::store(cacheKey, mHandle);
+        }
+
+        introspect();
 
         return true;
 }
 
 void ShaderProgram::use() {
         if (mHandle > 0)
-                glUseProgram(mHandle);
+                GLState::useProgram(mHandle);
 }
 
 string ShaderProgram::fileToString(const string& filename) {
@@ -69,6 +109,19 @@ string ShaderProgram::fileToString(const string& filename) {
         return ss.str();
 }
 
+string ShaderProgram::injectDefines(const string& source, const string& defines) {
+        if (defines.empty()) return source;
+
+        // #version must stay the first statement, so the defines go on the line after it
+        size_t versionPos = source.find("#version");
+        if (versionPos == string::npos) return defines + source;
+
+        size_t lineEnd = source.find('\n', versionPos);
+        if (lineEnd == string::npos) return source + "\n" + defines;
+
+        return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
 void ShaderProgram::checkCompileErrors(GLuint shader, ShaderType type) {
         int status = 0;
 
@@ -82,7 +135,7 @@ void ShaderProgram::checkCompileErrors(GLuint shader, ShaderType type) {
                         glGetProgramInfoLog(mHandle, length, &length, &errorLog[0]);
                         std::cerr << "Error! Program failed to link. " << errorLog << std::endl;
                 }
-        } else { // VERTEX or FRAGMENT
+        } else { // VERTEX, GEOMETRY or FRAGMENT
                 glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
                 if (status == GL_FALSE) {
                         GLint length = 0;
@@ -99,14 +152,92 @@ GLuint ShaderProgram::getProgram()const {
         return mHandle;
 }
 
+void ShaderProgram::introspect() {
+        mUniforms.clear();
+        mUniformBlocks.clear();
+        mReportedMissing.clear();
+
+        GLint uniformCount = 0, maxNameLength = 0;
+        glGetProgramiv(mHandle, GL_ACTIVE_UNIFORMS, &uniformCount);
+        glGetProgramiv(mHandle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+        std::vector<GLchar> nameBuffer(maxNameLength + 1);
+        for (GLuint i = 0; i < (GLuint)uniformCount; i++) {
+                // Block members have no location, they are written through the block's buffer
+                GLint blockIndex = -1;
+                glGetActiveUniformsiv(mHandle, 1, &i, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+                if (blockIndex != -1) continue;
+
+                GLint size = 0;
+                GLenum type = 0;
+                GLsizei length = 0;
+                glGetActiveUniform(mHandle, i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+                string name(nameBuffer.data(), length);
+
+                // Arrays are reported as "name[0]"; register the bare name and every element
+                size_t bracket = name.find('[');
+                if (bracket != string::npos) {
+                        string base = name.substr(0, bracket);
+                        for (GLint element = 0; element < size; element++) {
+                                string elementName = base + "[" + std::to_string(element) + "]";
+                                mUniforms[elementName] = { glGetUniformLocation(mHandle, elementName.c_str()), type };
+                        }
+                        mUniforms[base] = mUniforms[base + "[0]"];
+                } else {
+                        mUniforms[name] = { glGetUniformLocation(mHandle, name.c_str()), type };
+                }
+        }
+
+        GLint blockCount = 0, maxBlockNameLength = 0;
+        glGetProgramiv(mHandle, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+        glGetProgramiv(mHandle, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+
+        nameBuffer.assign(maxBlockNameLength + 1, 0);
+        for (GLuint i = 0; i < (GLuint)blockCount; i++) {
+                GLsizei length = 0;
+                glGetActiveUniformBlockName(mHandle, i, (GLsizei)nameBuffer.size(), &length, nameBuffer.data());
+                mUniformBlocks[string(nameBuffer.data(), length)] = i;
+        }
+}
+
+GLint ShaderProgram::resolveUniform(const GLchar* name, GLenum expectedType) {
+        auto it = mUniforms.find(name);
+        if (it == mUniforms.end()) {
+                // Declared but optimised out, or a typo: either way the handle is a no-op
+                std::cerr << "Warning: uniform '" << name << "' is not active in " << mName << std::endl;
+                return -1;
+        }
+
+        GLenum type = it->second.type;
+        bool intLike = type == GL_INT || type == GL_BOOL || type == GL_SAMPLER_2D || type == GL_SAMPLER_2D_ARRAY
+                || type == GL_SAMPLER_CUBE || type == GL_SAMPLER_2D_SHADOW || type == GL_SAMPLER_BUFFER
+                || type == GL_INT_SAMPLER_BUFFER || type == GL_UNSIGNED_INT_SAMPLER_BUFFER;
+        if (type != expectedType && !(expectedType == GL_INT && intLike)) {
+                std::cerr << "Warning: uniform '" << name << "' in " << mName << " is set with the wrong type" << std::endl;
+        }
+
+        return it->second.location;
+}
+
 GLint ShaderProgram::getUniformLocation(const GLchar* name) {
-        std::map<string, GLint>::iterator it = mUniformLocations.find(name);
+        auto it = mUniforms.find(name);
+        if (it != mUniforms.end()) {
+                return it->second.location;
+        }
 
-        if (it == mUniformLocations.end()) {
-                mUniformLocations[name] = glGetUniformLocation(mHandle, name);
+        if (mReportedMissing.find(name) == mReportedMissing.end()) {
+                mReportedMissing.insert(name);
+                std::cerr << "Warning: uniform '" << name << "' is not active in " << mName << std::endl;
         }
+        return -1;
+}
+
+bool ShaderProgram::hasUniform(const GLchar* name) const {
+        return mUniforms.find(name) != mUniforms.end();
+}
 
-        return mUniformLocations[name];
+bool ShaderProgram::hasUniformBlock(const GLchar* blockName) const {
+        return mUniformBlocks.find(blockName) != mUniformBlocks.end();
 }
 
 
@@ -145,8 +276,45 @@ void ShaderProgram::setUniform(const GLchar* name, const GLint& v){
         glUniform1i(loc, v);
 }
 
+void ShaderProgram::setUniform(Uniform<glm::vec2> u, const glm::vec2& v) {
+        glUniform2f(u.location, v.x, v.y);
+}
+
+void ShaderProgram::setUniform(Uniform<glm::vec3> u, const glm::vec3& v) {
+        glUniform3f(u.location, v.x, v.y, v.z);
+}
+
+void ShaderProgram::setUniform(Uniform<glm::ivec3> u, const glm::ivec3& v) {
+        glUniform3i(u.location, v.x, v.y, v.z);
+}
+
+void ShaderProgram::setUniform(Uniform<glm::vec4> u, const glm::vec4& v) {
+        glUniform4f(u.location, v.x, v.y, v.z, v.w);
+}
+
+void ShaderProgram::setUniform(Uniform<glm::mat4> u, const glm::mat4& m) {
+        glUniformMatrix4fv(u.location, 1, GL_FALSE, glm::value_ptr(m));
+}
+
+void ShaderProgram::setUniform(Uniform<GLfloat> u, GLfloat f) {
+        glUniform1f(u.location, f);
+}
+
+void ShaderProgram::setUniform(Uniform<GLint> u, GLint v) {
+        glUniform1i(u.location, v);
+}
+
+bool ShaderProgram::bindUniformBlock(const GLchar* blockName, GLuint bindingPoint) {
+        auto it = mUniformBlocks.find(blockName);
+        if (it == mUniformBlocks.end()) {
+                return false;
+        }
+
+        glUniformBlockBinding(mHandle, it->second, bindingPoint);
+        return true;
+}
+
 void ShaderProgram::setUniformSampler(const GLchar* name, const GLint& slot){
-        glActiveTexture(GL_TEXTURE0 + slot);
         GLint loc = getUniformLocation(name);
         glUniform1i(loc, slot);
 }
\ No newline at end of file
@@ -9,19 +9,32 @@
 #include <glm/glm.hpp>
 using std::string;
 #include <map>
+#include <set>
 
 class ShaderProgram {
     public:
+        // Uniform location resolved once after link. The type picks the glUniform* call, so a
+        // handle can only be set with the value type the shader declares.
+        template <typename T>
+        struct Uniform {
+                GLint location = -1;
+                bool isValid() const { return location >= 0; }
+        };
+
         ShaderProgram();
         ~ShaderProgram();
 
         enum ShaderType {
             VERTEX,
+            GEOMETRY,
             FRAGMENT,
             PROGRAM
         };
 
-        bool loadShaders(const char* vsFilename, const char* fsFilename);
+        // defines is inserted right after the #version line of both stages (e.g. "#define SHADOWS 1\n")
+        bool loadShaders(const char* vsFilename, const char* fsFilename, const string& defines = "");
+        // Same with a geometry stage between the two; gsFilename may be null
+        bool loadShaders(const char* vsFilename, const char* gsFilename, const char* fsFilename, const string& defines);
         void use();
 
         GLuint getProgram()const;
@@ -36,13 +49,54 @@ class ShaderProgram {
         void setUniformSampler(const GLchar* name, const GLint& slot);
         GLint getUniformLocation(const GLchar* name);
 
+        // Resolves a handle once; unknown names and type mismatches are reported here rather than per frame
+        template <typename T>
+        Uniform<T> getUniform(const GLchar* name) {
+                return Uniform<T>{ resolveUniform(name, glTypeOf(static_cast<const T*>(nullptr))) };
+        }
+
+        // Hot-path setters: no string building, no lookup
+        void setUniform(Uniform<glm::vec2> u, const glm::vec2& v);
+        void setUniform(Uniform<glm::vec3> u, const glm::vec3& v);
+        void setUniform(Uniform<glm::ivec3> u, const glm::ivec3& v);
+        void setUniform(Uniform<glm::vec4> u, const glm::vec4& v);
+        void setUniform(Uniform<glm::mat4> u, const glm::mat4& m);
+        void setUniform(Uniform<GLfloat> u, GLfloat f);
+        void setUniform(Uniform<GLint> u, GLint v);
+
+        bool hasUniform(const GLchar* name) const;
+        bool hasUniformBlock(const GLchar* blockName) const;
+
+        // Attaches a std140 uniform block to a shared binding point; false if the program does not use it
+        bool bindUniformBlock(const GLchar* blockName, GLuint bindingPoint);
+
     private:
         string fileToString(const string& filename);
+        static string injectDefines(const string& source, const string& defines);
         void checkCompileErrors(GLuint shader, ShaderType type);
+        void introspect();
+        GLint resolveUniform(const GLchar* name, GLenum expectedType);
+
+        static GLenum glTypeOf(const glm::vec2*) { return GL_FLOAT_VEC2; }
+        static GLenum glTypeOf(const glm::vec3*) { return GL_FLOAT_VEC3; }
+        static GLenum glTypeOf(const glm::ivec3*) { return GL_INT_VEC3; }
+        static GLenum glTypeOf(const glm::vec4*) { return GL_FLOAT_VEC4; }
+        static GLenum glTypeOf(const glm::mat4*) { return GL_FLOAT_MAT4; }
+        static GLenum glTypeOf(const GLfloat*) { return GL_FLOAT; }
+        static GLenum glTypeOf(const GLint*) { return GL_INT; } // Also bool and sampler uniforms
+
+        struct ActiveUniform {
+                GLint location;
+                GLenum type;
+        };
 
         GLuint mHandle;
+        string mName;
 
-        std::map<string, GLint> mUniformLocations;
+        // Filled from the linked program; std::less<> lets const char* names look up without a std::string
+        std::map<string, ActiveUniform, std::less<>> mUniforms;
+        std::map<string, GLuint, std::less<>> mUniformBlocks;
+        std::set<string, std::less<>> mReportedMissing;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "ShaderVariantCache.h"
+#include <iostream>
+
+ShaderDefines& ShaderDefines::set(const std::string& name, int value) {
+        mValues[name] = value;
+        return *this;
+}
+
+std::string ShaderDefines::toSource() const {
+        std::string source;
+        for (const auto& define : mValues) {
+                source += "#define " + define.first + " " + std::to_string(define.second) + "\n";
+        }
+        return source;
+}
+
+ShaderVariantCache::ShaderVariantCache(const std::string& vsFilename, const std::string& fsFilename, SetupFn setup)
+        : mVsFilename(vsFilename), mFsFilename(fsFilename), mSetup(std::move(setup)) {
+}
+
+ShaderProgram& ShaderVariantCache::get(const ShaderDefines& defines) {
+        std::string key = defines.toSource();
+
+        auto it = mVariants.find(key);
+        if (it != mVariants.end()) {
+                return *it->second;
+        }
+
+        auto program = std::make_unique<ShaderProgram>();
+        program->loadShaders(mVsFilename.c_str(), mFsFilename.c_str(), key);
+        if (mSetup) {
+                mSetup(*program);
+        }
+
+        std::cout << "Compiled variant " << mVariants.size() + 1 << " of " << mFsFilename << std::endl;
+
+        ShaderProgram& result = *program;
+        mVariants[key] = std::move(program);
+        return result;
+}
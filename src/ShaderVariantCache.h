@@ -0,0 +1,42 @@
+#ifndef SHADER_VARIANT_CACHE_H
+#define SHADER_VARIANT_CACHE_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "ShaderProgram.h"
+
+// A set of #define NAME VALUE lines. Kept sorted so equal sets produce the same key.
+class ShaderDefines {
+    public:
+        ShaderDefines& set(const std::string& name, int value);
+
+        std::string toSource() const;
+
+    private:
+        std::map<std::string, int> mValues;
+};
+
+// Compiles one program per define set on first use and keeps it for the rest of the run
+class ShaderVariantCache {
+    public:
+        // setup runs once on each new variant (block bindings, fixed sampler units...)
+        using SetupFn = std::function<void(ShaderProgram&)>;
+
+        ShaderVariantCache(const std::string& vsFilename, const std::string& fsFilename, SetupFn setup = nullptr);
+
+        ShaderProgram& get(const ShaderDefines& defines);
+
+        size_t getVariantCount() const { return mVariants.size(); }
+
+    private:
+        std::string mVsFilename;
+        std::string mFsFilename;
+        SetupFn mSetup;
+
+        std::map<std::string, std::unique_ptr<ShaderProgram>> mVariants;
+};
+
+#endif
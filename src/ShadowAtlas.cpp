@@ -0,0 +1,92 @@
+#include "ShadowAtlas.h"
+#include "Constants.h"
+#include <algorithm>
+
+namespace {
+    // Every other bit of a Morton index, i.e. one of its two coordinates
+    int compactBits(unsigned int value) {
+        int result = 0;
+        for (int bit = 0; bit < 16; bit++) {
+            result |= ((value >> (2 * bit)) & 1u) << bit;
+        }
+        return result;
+    }
+
+    long long tileArea(int tileSize, int tileCount) {
+        return (long long)tileSize * tileSize * tileCount;
+    }
+}
+
+void ShadowAtlas::begin() {
+    mRequests.clear();
+    mTiles.clear();
+    mUsedTexels = 0;
+}
+
+int ShadowAtlas::request(float importance, int tileCount) {
+    mRequests.push_back({ glm::clamp(importance, 0.0f, 1.0f), tileCount, 0, 0 });
+    return (int)mRequests.size() - 1;
+}
+
+void ShadowAtlas::pack() {
+    const long long budget = (long long)SHADOW_ATLAS_SIZE * SHADOW_ATLAS_SIZE;
+
+    // About one shadow texel per covered screen pixel, in powers of two
+    mUsedTexels = 0;
+    for (Request& request : mRequests) {
+        float wanted = request.importance * MAX_TILE_SIZE;
+        request.tileSize = MIN_TILE_SIZE;
+        while (request.tileSize < wanted && request.tileSize < MAX_TILE_SIZE) request.tileSize *= 2;
+        mUsedTexels += tileArea(request.tileSize, request.tileCount);
+    }
+
+    // Over budget: halve the least important request that can still shrink, drop once none can
+    mOrder.resize(mRequests.size());
+    for (size_t i = 0; i < mOrder.size(); i++) mOrder[i] = (int)i;
+    std::stable_sort(mOrder.begin(), mOrder.end(), [this](int a, int b) {
+        return mRequests[a].importance < mRequests[b].importance;
+    });
+    while (mUsedTexels > budget) {
+        Request* victim = nullptr;
+        for (int index : mOrder) {
+            if (mRequests[index].tileSize > MIN_TILE_SIZE) { victim = &mRequests[index]; break; }
+        }
+        if (victim) {
+            mUsedTexels -= tileArea(victim->tileSize, victim->tileCount) - tileArea(victim->tileSize / 2, victim->tileCount);
+            victim->tileSize /= 2;
+            continue;
+        }
+        for (int index : mOrder) {
+            if (mRequests[index].tileSize > 0) { victim = &mRequests[index]; break; }
+        }
+        mUsedTexels -= tileArea(victim->tileSize, victim->tileCount);
+        victim->tileSize = 0;
+    }
+
+    // Largest tiles first along a Morton curve: each tile starts on a multiple of its own area,
+    // so it is an aligned square and power-of-two tiles never overlap or leave holes.
+    // Ties keep the request order, so an unchanged light set keeps its tiles.
+    for (size_t i = 0; i < mOrder.size(); i++) mOrder[i] = (int)i;
+    std::stable_sort(mOrder.begin(), mOrder.end(), [this](int a, int b) {
+        return mRequests[a].tileSize > mRequests[b].tileSize;
+    });
+    unsigned int cursor = 0; // In MIN_TILE_SIZE cells
+    for (int index : mOrder) {
+        Request& request = mRequests[index];
+        if (request.tileSize == 0) continue;
+
+        unsigned int cellsPerSide = request.tileSize / MIN_TILE_SIZE;
+        request.firstTile = (int)mTiles.size();
+        for (int tile = 0; tile < request.tileCount; tile++) {
+            mTiles.push_back({ compactBits(cursor) * MIN_TILE_SIZE, compactBits(cursor >> 1) * MIN_TILE_SIZE, request.tileSize });
+            cursor += cellsPerSide * cellsPerSide;
+        }
+    }
+}
+
+glm::vec4 ShadowAtlas::getTileRect(int request, int tile) const {
+    if (mRequests[request].tileSize == 0) return glm::vec4(0.0f);
+    const Tile& t = getTile(request, tile);
+    float scale = 1.0f / SHADOW_ATLAS_SIZE;
+    return glm::vec4(t.x * scale, t.y * scale, t.size * scale, t.size * scale);
+}
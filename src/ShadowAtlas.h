@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+// Packs the shadow maps of local lights into one square depth texture of SHADOW_ATLAS_SIZE.
+// Each request gets square power-of-two tiles sized from its importance. When they do not all
+// fit, the least important requests shrink first, down to MIN_TILE_SIZE, and are dropped after.
+class ShadowAtlas {
+public:
+    static constexpr int MIN_TILE_SIZE = 128;
+    static constexpr int MAX_TILE_SIZE = 1024;
+
+    struct Tile {
+        int x, y, size; // Texels
+
+        bool operator==(const Tile& other) const { return x == other.x && y == other.y && size == other.size; }
+    };
+
+    // Forgets the requests of the previous frame
+    void begin();
+    // importance in [0, 1]: roughly the fraction of the screen the light's range covers.
+    // tileCount is 6 for a point light's cube faces, 1 for a spot light. Returns the request index.
+    int request(float importance, int tileCount);
+    void pack();
+
+    float getImportance(int request) const { return mRequests[request].importance; }
+    // 0 when the request was dropped
+    int getTileSize(int request) const { return mRequests[request].tileSize; }
+    long long getTexels(int request) const { return (long long)getTileSize(request) * getTileSize(request) * mRequests[request].tileCount; }
+    const Tile& getTile(int request, int tile) const { return mTiles[mRequests[request].firstTile + tile]; }
+    // xy: lower corner, zw: size, in atlas texture coordinates; all zero when the request was dropped
+    glm::vec4 getTileRect(int request, int tile) const;
+    // Texels handed out by the last pack
+    long long getUsedTexels() const { return mUsedTexels; }
+
+private:
+    struct Request {
+        float importance;
+        int tileCount;
+        int tileSize;
+        int firstTile;
+    };
+
+    std::vector<Request> mRequests;
+    std::vector<Tile> mTiles;
+    std::vector<int> mOrder; // Scratch
+    long long mUsedTexels = 0;
+};
@@ -1,4 +1,5 @@
 #include "Texture2D.h"
+#include "GLState.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../external/stb_image.h"
@@ -8,7 +9,7 @@ Texture2D::Texture2D() : mTexture(0) {
 }
 
 Texture2D::~Texture2D() {
-    glDeleteTextures(1, &mTexture);
+    GLState::deleteTextures(1, &mTexture);
 }
 
 bool Texture2D::loadTexture(const string& fileName, bool generateMipMaps) {
@@ -40,7 +41,7 @@ bool Texture2D::loadTexture(const string& fileName, bool generateMipMaps) {
 	}
 
 	glGenTextures(1, &mTexture);
-	glBindTexture(GL_TEXTURE_2D, mTexture);
+	GLState::bindTexture(GL_TEXTURE_2D, mTexture);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT); // up and down axis
@@ -54,14 +55,14 @@ bool Texture2D::loadTexture(const string& fileName, bool generateMipMaps) {
 		glGenerateMipmap(GL_TEXTURE_2D);
 
 	stbi_image_free(imageData);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
 
 	return true;
 }
 
 bool Texture2D::loadFromMemory(int width, int height, const unsigned char* data, bool generateMipMaps) {
     glGenTextures(1, &mTexture);
-    glBindTexture(GL_TEXTURE_2D, mTexture);
+    GLState::bindTexture(GL_TEXTURE_2D, mTexture);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -74,17 +75,15 @@ bool Texture2D::loadFromMemory(int width, int height, const unsigned char* data,
     if (generateMipMaps)
         glGenerateMipmap(GL_TEXTURE_2D);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
 
     return true;
 }
 
 void Texture2D::bind(GLuint textUnit) const {
-    glActiveTexture(GL_TEXTURE0 + textUnit);
-    glBindTexture(GL_TEXTURE_2D, mTexture);
+    GLState::bindTexture(textUnit, GL_TEXTURE_2D, mTexture);
 }
 
 void Texture2D::unbind(GLuint textUnit) const {
-    glActiveTexture(GL_TEXTURE0 + textUnit);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(textUnit, GL_TEXTURE_2D, 0);
 }
\ No newline at end of file
@@ -14,6 +14,7 @@ class Texture2D {
         bool loadFromMemory(int width, int height, const unsigned char* data, bool generateMipMaps = false);
         void bind(GLuint textUnit = 0) const;
         void unbind(GLuint textUnit = 0) const;
+        GLuint getTexture() const { return mTexture; }
     private:
         Texture2D(const Texture2D& rhs) {}
         Texture2D& operator = (const Texture2D& rhs) {}
@@ -0,0 +1,110 @@
+#include "TextureArray.h"
+#include "GLState.h"
+
+#include "../external/stb_image.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+	// Box-filters (downscale) or point-samples (upscale) an RGBA image into a size x size square
+	void resampleRGBA(const unsigned char* src, int srcWidth, int srcHeight, unsigned char* dst, int size) {
+		for (int y = 0; y < size; y++) {
+			int y0 = y * srcHeight / size;
+			int y1 = std::max(y0 + 1, (y + 1) * srcHeight / size);
+			for (int x = 0; x < size; x++) {
+				int x0 = x * srcWidth / size;
+				int x1 = std::max(x0 + 1, (x + 1) * srcWidth / size);
+
+				unsigned int sum[4] = { 0, 0, 0, 0 };
+				for (int sy = y0; sy < y1; sy++) {
+					for (int sx = x0; sx < x1; sx++) {
+						const unsigned char* p = src + (sy * srcWidth + sx) * 4;
+						for (int c = 0; c < 4; c++) sum[c] += p[c];
+					}
+				}
+
+				unsigned int count = (unsigned int)((y1 - y0) * (x1 - x0));
+				unsigned char* out = dst + (y * size + x) * 4;
+				for (int c = 0; c < 4; c++) out[c] = (unsigned char)(sum[c] / count);
+			}
+		}
+	}
+}
+
+TextureArray::TextureArray() : mTexture(0), mLayerCount(0) {
+}
+
+TextureArray::~TextureArray() {
+    GLState::deleteTextures(1, &mTexture);
+}
+
+bool TextureArray::loadLayers(const std::vector<string>& fileNames, int layerSize, bool generateMipMaps) {
+	GLint maxLayers = 0;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+	if ((GLint)fileNames.size() > maxLayers) {
+		std::cerr << "Too many texture layers (" << fileNames.size() << " > " << maxLayers << ")" << std::endl;
+		return false;
+	}
+
+	mLayerCount = (int)fileNames.size();
+
+	glGenTextures(1, &mTexture);
+	GLState::bindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, generateMipMaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, layerSize, layerSize, mLayerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	std::vector<unsigned char> layerData(layerSize * layerSize * 4);
+	bool allLoaded = true;
+
+	for (int layer = 0; layer < mLayerCount; layer++) {
+		int width, height, components;
+		unsigned char* imageData = stbi_load(fileNames[layer].c_str(), &width, &height, &components, STBI_rgb_alpha);
+
+		if (imageData == NULL) {
+			std::cerr << "Error loading texture '" << fileNames[layer] << "'" << std::endl;
+			// Magenta marks the missing layer instead of leaving it undefined
+			for (size_t i = 0; i < layerData.size(); i += 4) {
+				layerData[i] = 255; layerData[i + 1] = 0; layerData[i + 2] = 255; layerData[i + 3] = 255;
+			}
+			allLoaded = false;
+		} else {
+			// invert image
+			int widthInBytes = width * 4;
+			for (int row = 0; row < height / 2; row++) {
+				unsigned char* top = imageData + row * widthInBytes;
+				unsigned char* bottom = imageData + (height - row - 1) * widthInBytes;
+				for (int col = 0; col < widthInBytes; col++) {
+					unsigned char temp = top[col];
+					top[col] = bottom[col];
+					bottom[col] = temp;
+				}
+			}
+
+			resampleRGBA(imageData, width, height, layerData.data(), layerSize);
+			stbi_image_free(imageData);
+		}
+
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, layerSize, layerSize, 1, GL_RGBA, GL_UNSIGNED_BYTE, layerData.data());
+	}
+
+	if (generateMipMaps)
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+	GLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return allLoaded;
+}
+
+void TextureArray::bind(GLuint texUnit) const {
+    GLState::bindTexture(texUnit, GL_TEXTURE_2D_ARRAY, mTexture);
+}
+
+void TextureArray::unbind(GLuint texUnit) const {
+    GLState::bindTexture(texUnit, GL_TEXTURE_2D_ARRAY, 0);
+}
@@ -0,0 +1,30 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+using std::string;
+
+// All block textures in one GL_TEXTURE_2D_ARRAY, one layer per file. Every image is
+// resampled to layerSize x layerSize since array layers must share a resolution.
+class TextureArray {
+    public:
+        TextureArray();
+        virtual ~TextureArray();
+
+        bool loadLayers(const std::vector<string>& fileNames, int layerSize, bool generateMipMaps = true);
+        void bind(GLuint texUnit = 0) const;
+        void unbind(GLuint texUnit = 0) const;
+
+        int getLayerCount() const { return mLayerCount; }
+
+    private:
+        TextureArray(const TextureArray& rhs) = delete;
+        TextureArray& operator = (const TextureArray& rhs) = delete;
+
+        GLuint mTexture;
+        int mLayerCount;
+};
+
+#endif
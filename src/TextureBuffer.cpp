@@ -0,0 +1,45 @@
+#include "TextureBuffer.h"
+#include "GLState.h"
+
+TextureBuffer::TextureBuffer() : mBuffer(0), mTexture(0), mInternalFormat(GL_R32UI), mCapacity(0) {
+}
+
+TextureBuffer::~TextureBuffer() {
+        GLState::deleteTextures(1, &mTexture);
+        glDeleteBuffers(1, &mBuffer);
+}
+
+void TextureBuffer::create(GLenum internalFormat) {
+        mInternalFormat = internalFormat;
+
+        if (mBuffer == 0) {
+                glGenBuffers(1, &mBuffer);
+                glGenTextures(1, &mTexture);
+        }
+
+        // An empty buffer is not a valid texel source, start with a small allocation
+        mCapacity = 256;
+        glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, mCapacity, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        GLState::bindTexture(GL_TEXTURE_BUFFER, mTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, mInternalFormat, mBuffer);
+}
+
+void TextureBuffer::update(const void* data, size_t size) {
+        if (size == 0) return;
+
+        // Double so a slowly growing light count does not change the size every frame
+        while (mCapacity < size) mCapacity *= 2;
+
+        // Orphan the previous contents, the GPU may still be reading last frame's data
+        glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, mCapacity, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void TextureBuffer::bind(GLuint texUnit) const {
+        GLState::bindTexture(texUnit, GL_TEXTURE_BUFFER, mTexture);
+}
@@ -0,0 +1,28 @@
+#ifndef TEXTURE_BUFFER_H
+#define TEXTURE_BUFFER_H
+
+#include <GL/glew.h>
+#include <cstddef>
+
+// Buffer object exposed to shaders as a samplerBuffer / usamplerBuffer (texelFetch only).
+// Grows on demand, so per-frame data of unbounded size (light lists) fits without a fixed cap.
+class TextureBuffer {
+    public:
+        TextureBuffer();
+        ~TextureBuffer();
+
+        void create(GLenum internalFormat);
+        void update(const void* data, size_t size);
+        void bind(GLuint texUnit) const;
+
+    private:
+        TextureBuffer(const TextureBuffer& rhs) = delete;
+        TextureBuffer& operator = (const TextureBuffer& rhs) = delete;
+
+        GLuint mBuffer;
+        GLuint mTexture;
+        GLenum mInternalFormat;
+        size_t mCapacity;
+};
+
+#endif
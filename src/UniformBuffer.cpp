@@ -0,0 +1,35 @@
+#include "UniformBuffer.h"
+#include <iostream>
+
+UniformBuffer::UniformBuffer() : mBuffer(0), mBindingPoint(0), mSize(0) {
+}
+
+UniformBuffer::~UniformBuffer() {
+        glDeleteBuffers(1, &mBuffer);
+}
+
+void UniformBuffer::create(size_t size, GLuint bindingPoint) {
+        mSize = size;
+        mBindingPoint = bindingPoint;
+
+        if (mBuffer == 0) {
+                glGenBuffers(1, &mBuffer);
+        }
+
+        glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, mBuffer);
+}
+
+void UniformBuffer::update(const void* data, size_t size, size_t offset) {
+        if (offset + size > mSize) {
+                std::cerr << "UniformBuffer::update out of range (" << offset + size << " > " << mSize << ")" << std::endl;
+                return;
+        }
+
+        glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,27 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <GL/glew.h>
+#include <cstddef>
+
+// std140 uniform block storage bound to a fixed binding point shared by every program
+class UniformBuffer {
+    public:
+        UniformBuffer();
+        ~UniformBuffer();
+
+        void create(size_t size, GLuint bindingPoint);
+        void update(const void* data, size_t size, size_t offset = 0);
+
+        GLuint getBindingPoint() const { return mBindingPoint; }
+
+    private:
+        UniformBuffer(const UniformBuffer& rhs) = delete;
+        UniformBuffer& operator = (const UniformBuffer& rhs) = delete;
+
+        GLuint mBuffer;
+        GLuint mBindingPoint;
+        size_t mSize;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "World.h"
 #include "Chunk.h"
+#include "BlockRegistry.h"
 #include <chrono>
 #include <iostream>
 
@@ -29,18 +30,35 @@ void World::generate(int renderDistance, long long seed) {
         if (renderDistance == 1) {
                 Chunk* chunk = new Chunk(0, 0);
                 chunk->generate(m_seed);
-                chunk->buildMesh();
                 mChunks.push_back(chunk);
-                return;
+        } else {
+                for (int x = -renderDistance; x <= renderDistance; x++) {
+                        for (int z = -renderDistance; z <= renderDistance; z++) {
+                                Chunk* chunk = new Chunk(x, z);
+                                chunk->generate(m_seed);
+                                mChunks.push_back(chunk);
+                        }
+                }
         }
 
-        for (int x = -renderDistance; x <= renderDistance; x++) {
-                for (int z = -renderDistance; z <= renderDistance; z++) {
-                        Chunk* chunk = new Chunk(x, z);
-                        chunk->generate(m_seed);
-                        chunk->buildMesh();
-                        mChunks.push_back(chunk);
-                }
+        // Light spreads across chunk borders, so every chunk must exist before it is lit and meshed
+        linkNeighbours();
+        mLight.computeAll(mChunks);
+        mLightIndex.build(mChunks);
+        for (auto chunk : mChunks) {
+                chunk->buildMesh();
+        }
+}
+
+void World::linkNeighbours() {
+        for (auto chunk : mChunks) {
+                glm::vec3 pos = chunk->getWorldPosition();
+                int cx = (int)(pos.x / Chunk::CHUNK_SIZE);
+                int cz = (int)(pos.z / Chunk::CHUNK_SIZE);
+                chunk->setNeighbour(Chunk::SIDE_POS_X, findChunk(cx + 1, cz));
+                chunk->setNeighbour(Chunk::SIDE_NEG_X, findChunk(cx - 1, cz));
+                chunk->setNeighbour(Chunk::SIDE_POS_Z, findChunk(cx, cz + 1));
+                chunk->setNeighbour(Chunk::SIDE_NEG_Z, findChunk(cx, cz - 1));
         }
 }
 
@@ -60,6 +78,12 @@ Chunk* World::findChunk(int chunkX, int chunkZ) const {
         return nullptr;
 }
 
+Chunk* World::getChunkAt(const glm::vec3& worldPos) const {
+        int chunkX = (int)floor(floor(worldPos.x) / Chunk::CHUNK_SIZE);
+        int chunkZ = (int)floor(floor(worldPos.z) / Chunk::CHUNK_SIZE);
+        return findChunk(chunkX, chunkZ);
+}
+
 BlockType World::getBlockAt(const glm::vec3& worldPos) const {
         int wx = (int)floor(worldPos.x);
         int wy = (int)floor(worldPos.y);
@@ -93,70 +117,67 @@ bool World::setBlockAt(const glm::vec3& worldPos, BlockType type) {
         int localZ = wz - chunkZ * Chunk::CHUNK_SIZE;
 
         chunk->setBlock(localX, wy, localZ, type);
-        chunk->buildMesh();
-        return true;
-}
-
-std::vector<glm::vec3> World::getRedstoneLightPositions() const {
-        std::vector<glm::vec3> positions;
+        mLight.onBlockChanged(chunk, localX, wy, localZ);
+        mLightIndex.setBlock(glm::ivec3(wx, wy, wz), type);
+
+        // Only the section holding the edit changes, plus the neighbouring section
+        // whose faces were culled against this block when it sits on a section boundary,
+        // plus whatever sections the light update reached
+        LightPropagator::SectionSet dirty = mLight.takeDirtySections();
+        int section = wy / Chunk::SECTION_HEIGHT;
+        int localY = wy % Chunk::SECTION_HEIGHT;
+        dirty.insert({ chunk, section });
+        if (localY == 0) dirty.insert({ chunk, section - 1 });
+        if (localY == Chunk::SECTION_HEIGHT - 1) dirty.insert({ chunk, section + 1 });
+
+        // Faces across a chunk border take their AO corners from this block too, including the
+        // sections above and below it and, at a corner, the diagonal chunk
+        auto markChunk = [&](Chunk* other) {
+                if (!other) return;
+                dirty.insert({ other, section });
+                if (localY == 0) dirty.insert({ other, section - 1 });
+                if (localY == Chunk::SECTION_HEIGHT - 1) dirty.insert({ other, section + 1 });
+        };
+        Chunk* xNeighbour = nullptr;
+        Chunk* zNeighbour = nullptr;
+        if (localX == 0) xNeighbour = chunk->getNeighbour(Chunk::SIDE_NEG_X);
+        if (localX == Chunk::CHUNK_SIZE - 1) xNeighbour = chunk->getNeighbour(Chunk::SIDE_POS_X);
+        if (localZ == 0) zNeighbour = chunk->getNeighbour(Chunk::SIDE_NEG_Z);
+        if (localZ == Chunk::CHUNK_SIZE - 1) zNeighbour = chunk->getNeighbour(Chunk::SIDE_POS_Z);
+        markChunk(xNeighbour);
+        markChunk(zNeighbour);
+        if (xNeighbour && zNeighbour) {
+                Chunk::Side zSide = localZ == 0 ? Chunk::SIDE_NEG_Z : Chunk::SIDE_POS_Z;
+                markChunk(xNeighbour->getNeighbour(zSide));
+        }
 
-        for (auto chunk : mChunks) {
-                glm::vec3 chunkPos = chunk->getWorldPosition();
-
-                for (int x = 0; x < Chunk::CHUNK_SIZE; x++) {
-                        for (int y = 0; y < Chunk::CHUNK_HEIGHT; y++) {
-                                for (int z = 0; z < Chunk::CHUNK_SIZE; z++) {
-                                        if (chunk->getBlock(x, y, z) == BlockType::REDSTONE) {
-                                                glm::vec3 basePos = chunkPos + glm::vec3(x, y, z);
-
-                                                positions.push_back(basePos + glm::vec3(0.0f, 0.0f, 1.01f));
-                                                positions.push_back(basePos + glm::vec3(0.0f, 1.01f, 0.0f));
-                                                positions.push_back(basePos + glm::vec3(1.01f, 0.0f, 0.0f));
-
-                                                positions.push_back(basePos + glm::vec3(0.0f, 0.0f, -1.01f));
-                                                // positions.push_back(basePos + glm::vec3(0.0f, -1.01f, 0.0f));
-                                                positions.push_back(basePos + glm::vec3(-1.01f, 0.0f, 0.0f));
-                                        }
-                                }
-                        }
-                }
+        for (const auto& entry : dirty) {
+                entry.first->buildSectionMesh(entry.second);
         }
 
-        return positions;
+        // Blocks are centred on integer coordinates; faces of the neighbours lie on this box
+        glm::vec3 blockCenter((float)wx, (float)wy, (float)wz);
+        for (const auto& listener : mChangeListeners) {
+                listener(blockCenter - 0.5f, blockCenter + 0.5f);
+        }
+        return true;
 }
 
-std::vector<glm::vec3> World::getTorchLightPositions() const {
-        std::vector<glm::vec3> positions;
+void World::selectBlockLights(const glm::vec3& eye, int maxEmitters, std::vector<PointLight>& lights,
+                              LightIndex::QueryStats& stats) const {
+        mLightIndex.query(eye, maxEmitters, mSelectedEmitters, stats);
 
-        for (auto chunk : mChunks) {
-                glm::vec3 chunkPos = chunk->getWorldPosition();
-
-                for (int x = 0; x < Chunk::CHUNK_SIZE; x++) {
-                        for (int y = 0; y < Chunk::CHUNK_HEIGHT; y++) {
-                                for (int z = 0; z < Chunk::CHUNK_SIZE; z++) {
-                                        if (chunk->getBlock(x, y, z) == BlockType::TORCH) {
-                                                positions.push_back(
-                                                        chunkPos
-                                                        + glm::vec3(x + 0.2f, y + 0.2f, z)
-                                                );
-                                                positions.push_back(
-                                                        chunkPos
-                                                        + glm::vec3(x - 0.2f, y + 0.2f, z)
-                                                );
-                                                positions.push_back(
-                                                        chunkPos
-                                                        + glm::vec3(x, y + 0.2f, z + 0.2f)
-                                                );
-                                                positions.push_back(
-                                                        chunkPos
-                                                        + glm::vec3(x, y + 0.2f, z - 0.2f)
-                                                );
-                                        }
-                                }
-                        }
-                }
+        for (const auto& emitter : mSelectedEmitters) {
+                const BlockDefinition& def = BlockRegistry::get(emitter.type);
+                if (!def.createLight) continue;
+
+                // One light per emitter keeps the light count, and the point shadows spent on it, per block
+                PointLight light = def.createLight(glm::vec3(emitter.block) + def.lightOffset);
+                light.ambient *= def.lightScale;
+                light.diffuse *= def.lightScale;
+                light.specular *= def.lightScale;
+                lights.push_back(light);
         }
-        return positions;
 }
 
 void World::localToChunkCoords(int worldX, int worldY, int worldZ, int& chunkX, int& chunkZ, int& localX, int& localY, int& localZ) const {
@@ -1,13 +1,20 @@
 #pragma once
 
+#include <functional>
 #include <vector>
 #include <glm/glm.hpp>
 #include "Block.h"
+#include "Light.h"
+#include "LightPropagator.h"
+#include "LightIndex.h"
 
 class Chunk; // Forward declaration
 
 class World {
 public:
+	// Called after an edit with the world-space box whose geometry changed
+	using ChangeListener = std::function<void(const glm::vec3& boxMin, const glm::vec3& boxMax)>;
+
 	World();
 	~World();
 
@@ -16,11 +23,15 @@ public:
 
 	const std::vector<Chunk*>& getChunks() const { return mChunks; }
 
-	std::vector<glm::vec3> getRedstoneLightPositions() const;
-	std::vector<glm::vec3> getTorchLightPositions() const;
+	// One point light for each of the maxEmitters emissive blocks most relevant to eye, as
+	// described by the block registry. The most relevant emitter comes first.
+	void selectBlockLights(const glm::vec3& eye, int maxEmitters, std::vector<PointLight>& lights,
+	                       LightIndex::QueryStats& stats) const;
 
     bool setBlockAt(const glm::vec3& worldPos, BlockType type);
+	void addChangeListener(ChangeListener listener) { mChangeListeners.push_back(std::move(listener)); }
     BlockType getBlockAt(const glm::vec3& worldPos) const;
+    Chunk* getChunkAt(const glm::vec3& worldPos) const;
 
 	BlockType getBlock(int x, int y, int z) const;
 	void localToChunkCoords(int worldX, int worldY, int worldZ,
@@ -31,5 +42,11 @@ public:
 private:
 	long long m_seed;
 	std::vector<Chunk*> mChunks;
+	LightPropagator mLight;
+	LightIndex mLightIndex;
+	mutable std::vector<LightIndex::Emitter> mSelectedEmitters; // Scratch for selectBlockLights
+	std::vector<ChangeListener> mChangeListeners;
+
 	Chunk* findChunk(int chunkX, int chunkZ) const;
+	void linkNeighbours();
 };
\ No newline at end of file